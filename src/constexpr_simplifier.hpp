@@ -0,0 +1,373 @@
+#ifndef CONSTEXPR_SIMPLIFIER_HPP
+#define CONSTEXPR_SIMPLIFIER_HPP
+
+
+#include <cstddef>
+#include <stdexcept>
+#include <initializer_list>
+
+
+//
+// Compile-time logical function simplifier (header-only, C++14)
+//
+// The same algorithm as simplifier works on fixed-size cubes
+// so that a small truth table is simplified in a constant expression.
+//  1. Merge implicants which differ in one variable, level by level
+//     (the compression table is a dense bit table of all the cubes)
+//  2. Take essential prime implicants, and find a minimum cover of the rest
+//     by branch-and-bound, like cover_solver does with one thread.
+//     A greedy cover gives the initial bound, sets are counted word by word,
+//     and the search updates one node in place instead of copying it.
+// Evaluation of a table of 10 variables fits in the default limits of GCC
+// unless it has hundreds of prime implicants (see constexpr_simplifier_check.cpp).
+//
+// ex.
+//  constexpr auto f = quine_mccluskey::compile_time::minimize(
+//          quine_mccluskey::compile_time::truth_table<3>({1, 3, 7}, {5}));
+//  static_assert(f.size == 1 && f(3) && !f(2), "");
+//
+namespace quine_mccluskey {
+namespace compile_time {
+
+
+constexpr unsigned max_vars = 10;
+
+// The i-th variable of N variables is bit (N - 1 - i),
+// so that the value of a minterm is its index
+struct cube {
+    unsigned value;     // 1 if the variable is true
+    unsigned mask;      // 1 if the variable is not don't care
+    constexpr bool contains(unsigned minterm) const
+        { return (minterm & mask) == value; }
+};
+
+template<std::size_t Bits>
+struct fixed_bitset {
+    static constexpr std::size_t words = (Bits + 63) / 64;
+    unsigned long long word[words];
+
+    constexpr fixed_bitset() : word{} {}
+    constexpr bool test(std::size_t i) const
+        { return (word[i / 64] >> (i % 64)) & 1; }
+    constexpr void set(std::size_t i)
+        { word[i / 64] |= 1ull << (i % 64); }
+    constexpr void reset(std::size_t i)
+        { word[i / 64] &= ~(1ull << (i % 64)); }
+    constexpr bool intersects(const fixed_bitset &bits) const {
+        for( std::size_t i = 0; i < words; ++i )
+            if( word[i] & bits.word[i] )
+                return true;
+        return false;
+    }
+};
+
+namespace detail {
+
+constexpr std::size_t popcount(unsigned long long x) {
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<std::size_t>((x * 0x0101010101010101ull) >> 56);
+}
+
+// Index of the lowest 1 of x, which must not be 0
+constexpr std::size_t lowest_bit(unsigned long long x) {
+    return popcount((x & (~x + 1)) - 1);
+}
+
+}   // namespace detail
+
+template<unsigned N>
+struct truth_table {
+    static_assert(0 < N && N <= max_vars, "truth_table: number of variables must be from 1 to max_vars");
+    static constexpr unsigned size = 1u << N;
+    bool on[size], dc[size];
+
+    constexpr truth_table() : on{}, dc{} {}
+    constexpr truth_table(std::initializer_list<unsigned> minterms,
+            std::initializer_list<unsigned> dont_cares = {}) : on{}, dc{} {
+        for( unsigned m : minterms )
+            on[check(m)] = true;
+        for( unsigned m : dont_cares )
+            dc[check(m)] = true;
+    }
+
+    // Bit i of on (dc) is the value of minterm i
+    static constexpr truth_table from_bits(unsigned long long on, unsigned long long dc = 0) {
+        static_assert(N <= 6, "truth_table: from_bits() supports up to 6 variables");
+        truth_table table;
+        for( unsigned m = 0; m < size; ++m ) {
+            table.on[m] = (on >> m) & 1;
+            table.dc[m] = (dc >> m) & 1;
+        }
+        return table;
+    }
+
+private:
+    static constexpr unsigned check(unsigned minterm) {
+        return minterm < size ? minterm : throw std::out_of_range("truth_table: minterm is out of range");
+    }
+};
+
+// Minimum sum of products form
+template<unsigned N, std::size_t MaxTerms>
+struct cover {
+    cube terms[MaxTerms];
+    std::size_t size;
+
+    constexpr cover() : terms{}, size(0) {}
+    constexpr bool operator()(unsigned arg) const {
+        for( std::size_t i = 0; i < size; ++i )
+            if( terms[i].contains(arg) )
+                return true;
+        return false;
+    }
+};
+
+
+namespace detail {
+
+template<unsigned N, std::size_t MaxPrimes>
+class solver {
+public:
+    static constexpr unsigned size = 1u << N;
+    static constexpr unsigned full_mask = size - 1;
+    typedef fixed_bitset<size> minterm_set;
+    typedef fixed_bitset<MaxPrimes> prime_set;
+
+    struct node {
+        minterm_set covered;
+        prime_set allowed;
+        std::size_t chosen[MaxPrimes];
+        std::size_t num_chosen;
+        constexpr node() : covered(), allowed(), chosen{}, num_chosen(0) {}
+    };
+
+    constexpr explicit solver(const truth_table<N> &table)
+        : table_(table), implicant_(), primes_{}, num_primes_(0),
+          minterms_{}, num_minterms_(0), coverage_{}, covered_by_{}, best_()
+    {
+        for( unsigned m = 0; m < size; ++m )
+            if( table_.on[m] )
+                minterms_[num_minterms_++] = m;
+        make_implicants();
+        make_primes();
+    }
+
+    constexpr cover<N, MaxPrimes> solve() {
+        cover<N, MaxPrimes> result;
+        if( num_minterms_ == 0 )
+            return result;
+        node root;
+        for( std::size_t p = 0; p < num_primes_; ++p )
+            root.allowed.set(p);
+        // Take essential prime implicants
+        for( std::size_t m = 0; m < num_minterms_; ++m ) {
+            std::size_t p = first(covered_by_[m]);
+            if( count(covered_by_[m]) == 1 && root.allowed.test(p) )
+                choose(root, p);
+        }
+        greedy_cover(root);
+        search(root);
+        for( std::size_t i = 0; i < best_.num_chosen; ++i )
+            result.terms[result.size++] = primes_[best_.chosen[i]];
+        return result;
+    }
+
+private:
+    static constexpr std::size_t index(unsigned mask, unsigned value)
+        { return (std::size_t(mask) << N) | value; }
+
+    template<std::size_t Bits>
+    static constexpr std::size_t count(const fixed_bitset<Bits> &bits) {
+        std::size_t n = 0;
+        for( std::size_t i = 0; i < fixed_bitset<Bits>::words; ++i )
+            n += popcount(bits.word[i]);
+        return n;
+    }
+
+    template<std::size_t Bits>
+    static constexpr std::size_t first(const fixed_bitset<Bits> &bits) {
+        for( std::size_t i = 0; i < fixed_bitset<Bits>::words; ++i )
+            if( bits.word[i] )
+                return i * 64 + lowest_bit(bits.word[i]);
+        return Bits;
+    }
+
+    // Uncovered minterms of the i-th word of covered
+    constexpr unsigned long long uncovered(const minterm_set &covered, std::size_t i) const {
+        unsigned long long bits = ~covered.word[i];
+        if( i == num_minterms_ / 64 )
+            bits &= (1ull << (num_minterms_ % 64)) - 1;
+        else if( num_minterms_ / 64 < i )
+            bits = 0;
+        return bits;
+    }
+
+    // A cube is an implicant if both of its halves split by a don't care are implicants.
+    // Cubes are visited from minterms to larger cubes, which is the compression table
+    constexpr void make_implicants() {
+        for( unsigned mask = size; mask-- > 0; ) {
+            unsigned dash = ~mask & full_mask & (~(~mask & full_mask) + 1);
+            for( unsigned value = mask; ; value = (value - 1) & mask ) {
+                bool found = (mask == full_mask)
+                    ? (table_.on[value] || table_.dc[value])
+                    : (implicant_.test(index(mask | dash, value)) && implicant_.test(index(mask | dash, value | dash)));
+                if( found )
+                    implicant_.set(index(mask, value));
+                if( value == 0 )
+                    break;
+            }
+        }
+    }
+
+    // Prime implicants are implicants which cannot be merged any more.
+    // The ones covering don't cares only are never used.
+    constexpr void make_primes() {
+        for( unsigned mask = 0; mask < size; ++mask ) {
+            for( unsigned value = mask; ; value = (value - 1) & mask ) {
+                if( implicant_.test(index(mask, value)) && is_prime(mask, value) ) {
+                    cube term{ value, mask };
+                    minterm_set coverage;
+                    for( std::size_t m = 0; m < num_minterms_; ++m )
+                        if( term.contains(minterms_[m]) )
+                            coverage.set(m);
+                    if( count(coverage) != 0 ) {
+                        if( num_primes_ == MaxPrimes )
+                            throw std::length_error("minimize: too many prime implicants, increase MaxPrimes");
+                        for( std::size_t m = 0; m < num_minterms_; ++m )
+                            if( coverage.test(m) )
+                                covered_by_[m].set(num_primes_);
+                        coverage_[num_primes_] = coverage;
+                        primes_[num_primes_++] = term;
+                    }
+                }
+                if( value == 0 )
+                    break;
+            }
+        }
+    }
+
+    constexpr bool is_prime(unsigned mask, unsigned value) const {
+        for( unsigned bits = mask; bits; bits &= bits - 1 ) {
+            unsigned bit = bits & (~bits + 1);
+            if( implicant_.test(index(mask & ~bit, value & ~bit)) )
+                return false;
+        }
+        return true;
+    }
+
+    constexpr void choose(node &task, std::size_t p) const {
+        task.chosen[task.num_chosen++] = p;
+        task.allowed.reset(p);
+        for( std::size_t i = 0; i < minterm_set::words; ++i )
+            task.covered.word[i] |= coverage_[p].word[i];
+    }
+
+    // A greedy cover of the core is the first best, which gives the initial bound
+    constexpr void greedy_cover(const node &root) {
+        best_ = root;
+        while( count(best_.covered) != num_minterms_ ) {
+            std::size_t best_gain = 0, best_prime = num_primes_;
+            for( std::size_t p = 0; p < num_primes_; ++p ) {
+                if( !best_.allowed.test(p) )
+                    continue;
+                std::size_t gain = 0;
+                for( std::size_t i = 0; i < minterm_set::words; ++i )
+                    gain += popcount(coverage_[p].word[i] & ~best_.covered.word[i]);
+                if( best_gain < gain ) {
+                    best_gain = gain;
+                    best_prime = p;
+                }
+            }
+            choose(best_, best_prime);
+        }
+    }
+
+    // The number of uncovered minterms which share no candidate prime implicant
+    constexpr std::size_t lower_bound(const node &task) const {
+        prime_set used;
+        std::size_t bound = 0;
+        for( std::size_t w = 0; w < minterm_set::words; ++w ) {
+            for( unsigned long long bits = uncovered(task.covered, w); bits; bits &= bits - 1 ) {
+                const prime_set &row = covered_by_[w * 64 + lowest_bit(bits)];
+                bool shared = false;
+                for( std::size_t i = 0; i < prime_set::words; ++i )
+                    shared = shared || (row.word[i] & task.allowed.word[i] & used.word[i]);
+                if( !shared ) {
+                    ++bound;
+                    for( std::size_t i = 0; i < prime_set::words; ++i )
+                        used.word[i] |= row.word[i] & task.allowed.word[i];
+                }
+            }
+        }
+        return bound;
+    }
+
+    // task is updated in place and restored before returning
+    constexpr void search(node &task) {
+        // Select the uncovered minterm which has the fewest candidates
+        std::size_t selected = num_minterms_, fewest = MaxPrimes + 1;
+        for( std::size_t w = 0; w < minterm_set::words; ++w ) {
+            for( unsigned long long bits = uncovered(task.covered, w); bits; bits &= bits - 1 ) {
+                std::size_t m = w * 64 + lowest_bit(bits);
+                std::size_t n = 0;
+                for( std::size_t i = 0; i < prime_set::words; ++i )
+                    n += popcount(covered_by_[m].word[i] & task.allowed.word[i]);
+                if( n == 0 )
+                    return;
+                if( n < fewest ) {
+                    fewest = n;
+                    selected = m;
+                }
+            }
+        }
+        if( selected == num_minterms_ ) {
+            if( task.num_chosen < best_.num_chosen )
+                best_ = task;
+            return;
+        }
+        if( best_.num_chosen <= task.num_chosen + lower_bound(task) )
+            return;
+        // The preceding candidates stay excluded from the following branches
+        const minterm_set covered = task.covered;
+        const prime_set allowed = task.allowed;
+        for( std::size_t i = 0; i < prime_set::words; ++i ) {
+            for( unsigned long long bits = covered_by_[selected].word[i] & allowed.word[i]; bits; bits &= bits - 1 ) {
+                choose(task, i * 64 + lowest_bit(bits));
+                search(task);
+                --task.num_chosen;
+                task.covered = covered;
+            }
+        }
+        task.allowed = allowed;
+    }
+
+    truth_table<N> table_;
+    fixed_bitset<(std::size_t(1) << (2 * N))> implicant_;   // indexed by (mask, value)
+    cube primes_[MaxPrimes];
+    std::size_t num_primes_;
+    unsigned minterms_[size];
+    std::size_t num_minterms_;
+    minterm_set coverage_[MaxPrimes];       // minterms covered by each prime implicant
+    prime_set covered_by_[size];            // prime implicants covering each minterm
+    node best_;
+};
+
+}   // namespace detail
+
+
+// Return a minimum cover of the truth table
+// A constant expression if table is, otherwise computed at run time
+template<std::size_t MaxPrimes = 128, unsigned N>
+constexpr cover<N, MaxPrimes> minimize(const truth_table<N> &table) {
+    detail::solver<N, MaxPrimes> solver(table);
+    return solver.solve();
+}
+
+
+}   // namespace compile_time
+}   // namespace quine_mccluskey
+
+
+#endif  // CONSTEXPR_SIMPLIFIER_HPP
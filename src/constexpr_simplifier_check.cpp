@@ -0,0 +1,68 @@
+
+//
+// Compile-time checks of constexpr_simplifier.hpp
+// Nothing is linked; this translation unit compiles only if every table
+// is simplified within the limits of constant evaluation
+//
+#include <cstddef>
+#include "constexpr_simplifier.hpp"
+
+using namespace quine_mccluskey::compile_time;
+
+namespace {
+
+
+// Return true if the cover has the same value as the table except for don't cares
+template<unsigned N, std::size_t MaxTerms>
+constexpr bool matches(const cover<N, MaxTerms> &f, const truth_table<N> &table) {
+    for( unsigned m = 0; m < table.size; ++m )
+        if( !table.dc[m] && f(m) != table.on[m] )
+            return false;
+    return true;
+}
+
+// Pseudo-random table without structure
+template<unsigned N>
+constexpr truth_table<N> hashed_table() {
+    truth_table<N> table;
+    for( unsigned m = 0; m < table.size; ++m )
+        table.on[m] = (m * 2654435761u >> 13) & 1;
+    return table;
+}
+
+// a > b, where a is the upper 5 bits and b is the lower 5 bits
+constexpr truth_table<10> greater_table() {
+    truth_table<10> table;
+    for( unsigned m = 0; m < table.size; ++m )
+        table.on[m] = (m >> 5) > (m & 31);
+    return table;
+}
+
+// a + b >= 24 for a, b in [0, 24], the other inputs never happen
+constexpr truth_table<10> threshold_table() {
+    truth_table<10> table;
+    for( unsigned m = 0; m < table.size; ++m ) {
+        unsigned a = m >> 5, b = m & 31;
+        if( 24 < a || 24 < b )
+            table.dc[m] = true;
+        else
+            table.on[m] = (24 <= a + b);
+    }
+    return table;
+}
+
+constexpr auto example = minimize(truth_table<3>({1, 3, 7}, {5}));
+static_assert(example.size == 1 && example.terms[0].mask == 1 && example.terms[0].value == 1, "f = C");
+
+constexpr auto hashed = minimize(hashed_table<7>());
+static_assert(hashed.size == 26 && matches(hashed, hashed_table<7>()), "hashed table of 7 variables");
+
+constexpr auto greater = minimize(greater_table());
+static_assert(greater.size == 31 && matches(greater, greater_table()), "5-bit comparator");
+
+constexpr auto threshold = minimize(threshold_table());
+static_assert(threshold.size == 26 && matches(threshold, threshold_table()), "threshold with don't cares");
+
+
+}   // namespace
+
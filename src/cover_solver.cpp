@@ -0,0 +1,322 @@
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <condition_variable>
+#include "cover_solver.hpp"
+
+using namespace std;
+
+namespace quine_mccluskey {
+
+
+static int popcount(std::uint64_t word) {
+    return __builtin_popcountll(word);
+}
+
+cover_solver::cover_solver(const counted_vector<bitset_type> &coverage, size_t num_minterms, unsigned threads)
+    : num_primes_(coverage.size()), num_minterms_(num_minterms),
+      minterm_words_((num_minterms + word_bits - 1) / word_bits),
+      prime_words_((coverage.size() + word_bits - 1) / word_bits),
+      coverage_(num_primes_ * minterm_words_), covered_by_(num_minterms_ * prime_words_),
+      threads_(threads), best_(0), pending_(0), queued_(0)
+{
+    if( threads_ == 0 )
+        threads_ = std::max(std::thread::hardware_concurrency(), 1u);
+    for( size_t p = 0; p < num_primes_; ++p )
+        for( size_t m = coverage[p].find_first(); m != bitset_type::npos; m = coverage[p].find_next(m) ) {
+            coverage_[p * minterm_words_ + m / word_bits] |= word_type(1) << (m % word_bits);
+            covered_by_[m * prime_words_ + p / word_bits] |= word_type(1) << (p % word_bits);
+        }
+}
+
+const counted_vector<cover_solver::cover_type>& cover_solver::solve() {
+    result_.clear();
+    found_.clear();
+    if( num_minterms_ == 0 || num_primes_ == 0 )
+        return result_;
+
+    // Take essential prime implicants
+    node root = { words_type(minterm_words_), words_type(prime_words_), cover_type(), 0 };
+    for( size_t p = 0; p < num_primes_; ++p )
+        root.allowed[p / word_bits] |= word_type(1) << (p % word_bits);
+    for( size_t m = 0; m < num_minterms_; ++m ) {
+        const word_type *row = covered_by(m);
+        size_t count = 0, p = 0;
+        for( size_t w = 0; w < prime_words_; ++w ) {
+            if( row[w] && count == 0 )
+                p = w * word_bits + __builtin_ctzll(row[w]);
+            count += popcount(row[w]);
+        }
+        if( count == 0 )
+            throw std::runtime_error("cover: a minterm is not covered by any prime implicant");
+        word_type bit = word_type(1) << (p % word_bits);
+        if( count == 1 && (root.allowed[p / word_bits] & bit) ) {
+            root.chosen.push_back(p);
+            root.allowed[p / word_bits] &= ~bit;
+            for( size_t w = 0; w < minterm_words_; ++w )
+                root.covered[w] |= coverage_of(p)[w];
+        }
+    }
+    if( count_covered(root.covered) == num_minterms_ ) {
+        std::sort(root.chosen.begin(), root.chosen.end());
+        result_.push_back(root.chosen);
+        return result_;
+    }
+
+    // Branch-and-bound on the cyclic core.
+    // Only the covers of the least size are ever stored
+    best_ = root.chosen.size() + greedy_bound(root);
+    keep_ties_ = false;
+    search(node(root));
+    keep_ties_ = true;
+    search(std::move(root));
+
+    result_.reserve(found_.size());
+    for( auto &cover : found_ ) {
+        std::sort(cover.begin(), cover.end());
+        result_.push_back(std::move(cover));
+    }
+    std::sort(result_.begin(), result_.end());
+    result_.erase(std::unique(result_.begin(), result_.end()), result_.end());
+    return result_;
+}
+
+void cover_solver::search(node &&root) {
+    workers_.clear();
+    workers_.resize(threads_);
+    for( auto &w : workers_ )
+        w.used.resize(prime_words_);
+    pending_ = 0;
+    queued_ = 0;
+    push_task(0, std::move(root));
+    vector<std::thread> pool;
+    for( int id = 1; id < threads_; ++id )
+        pool.emplace_back(&cover_solver::run_worker, this, id);
+    run_worker(0);
+    for( auto &th : pool )
+        th.join();
+}
+
+// A worker sleeps while no task is queued, and leaves when the search is over
+void cover_solver::run_worker(int id) {
+    node task;
+    for( ;; ) {
+        if( pop_task(id, task) || steal_task(id, task) ) {
+            expand(id, task);
+            if( --pending_ == 0 ) {
+                std::lock_guard<std::mutex> lock(idle_mtx_);
+                idle_cv_.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(idle_mtx_);
+        idle_cv_.wait(lock, [this]{ return pending_.load() == 0 || 0 < queued_.load(); });
+        if( pending_.load() == 0 )
+            return;
+    }
+}
+
+// Pop the newest task of its own (depth-first)
+bool cover_solver::pop_task(int id, node &task) {
+    std::lock_guard<std::mutex> lock(workers_[id].mtx);
+    if( workers_[id].tasks.empty() )
+        return false;
+    task = std::move(workers_[id].tasks.back());
+    workers_[id].tasks.pop_back();
+    --queued_;
+    return true;
+}
+
+// Steal the oldest task, which is the largest subtree, from another worker
+bool cover_solver::steal_task(int id, node &task) {
+    for( int i = 1; i < threads_; ++i ) {
+        worker &victim = workers_[(id + i) % threads_];
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        if( victim.tasks.empty() )
+            continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        --queued_;
+        return true;
+    }
+    return false;
+}
+
+void cover_solver::push_task(int id, node &&task) {
+    ++pending_;
+    {
+        std::lock_guard<std::mutex> lock(workers_[id].mtx);
+        workers_[id].tasks.push_back(std::move(task));
+        ++queued_;
+    }
+    std::lock_guard<std::mutex> lock(idle_mtx_);
+    idle_cv_.notify_one();
+}
+
+void cover_solver::expand(int id, node &task) {
+    if( count_covered(task.covered) == num_minterms_ ) {
+        record(task.chosen);
+        return;
+    }
+    // Covers which have the same size as the best are kept only while collecting them
+    const size_t bound = task.chosen.size() + lower_bound(task, workers_[id].used);
+    const size_t best = best_.load();
+    if( best < bound || (best == bound && !keep_ties_) )
+        return;
+    int m = select_minterm(task);
+    if( m < 0 )
+        return;
+    // Branch on each prime implicant covering m.
+    // The preceding candidates are excluded from the following branches
+    // so that the same cover is never searched twice.
+    // Only the tasks to be pushed are copied, and they are pushed only near the root
+    // while few tasks are queued. Otherwise task is updated in place
+    // and restored from the trail after each branch.
+    worker &self = workers_[id];
+    const size_t level = task.chosen.size();
+    if( self.covered_trail.size() < (level + 1) * minterm_words_ ) {
+        self.covered_trail.resize((level + 1) * minterm_words_);
+        self.allowed_trail.resize((level + 1) * prime_words_);
+    }
+    std::copy(task.covered.begin(), task.covered.end(), self.covered_trail.begin() + level * minterm_words_);
+    std::copy(task.allowed.begin(), task.allowed.end(), self.allowed_trail.begin() + level * prime_words_);
+    const word_type *row = covered_by(m);
+    for( size_t w = 0; w < prime_words_; ++w )
+        for( word_type bits = row[w] & self.allowed_trail[level * prime_words_ + w]; bits; bits &= bits - 1 ) {
+            size_t p = w * word_bits + __builtin_ctzll(bits);
+            task.allowed[w] &= ~(bits & (~bits + 1));
+            if( task.depth < spawn_depth && 1 < threads_ && queued_.load() < 2 * threads_ ) {
+                node child = { task.covered, task.allowed, task.chosen, task.depth + 1 };
+                for( size_t i = 0; i < minterm_words_; ++i )
+                    child.covered[i] |= coverage_of(p)[i];
+                child.chosen.push_back(p);
+                push_task(id, std::move(child));
+                continue;
+            }
+            for( size_t i = 0; i < minterm_words_; ++i )
+                task.covered[i] |= coverage_of(p)[i];
+            task.chosen.push_back(p);
+            ++task.depth;
+            expand(id, task);
+            --task.depth;
+            task.chosen.pop_back();
+            // The trail may have been reallocated by the deeper levels
+            auto saved = self.covered_trail.begin() + level * minterm_words_;
+            std::copy(saved, saved + minterm_words_, task.covered.begin());
+        }
+    auto saved = self.allowed_trail.begin() + level * prime_words_;
+    std::copy(saved, saved + prime_words_, task.allowed.begin());
+}
+
+// The first search only lowers the bound.
+// Every cover found by the second one has the least size
+void cover_solver::record(const cover_type &cover) {
+    if( keep_ties_ ) {
+        std::lock_guard<std::mutex> lock(result_mtx_);
+        found_.push_back(cover);
+        return;
+    }
+    size_t size = cover.size();
+    size_t best = best_.load();
+    while( size < best && !best_.compare_exchange_weak(best, size) )
+        ;
+}
+
+// The number of uncovered minterms which share no candidate prime implicant
+// used: scratch set of the candidates of the counted minterms
+size_t cover_solver::lower_bound(const node &task, words_type &used) const {
+    std::fill(used.begin(), used.end(), 0);
+    size_t bound = 0;
+    for( size_t mw = 0; mw < minterm_words_; ++mw )
+        for( word_type bits = uncovered_word(task.covered, mw); bits; bits &= bits - 1 ) {
+            const word_type *row = covered_by(mw * word_bits + __builtin_ctzll(bits));
+            word_type any = 0, shared = 0;
+            for( size_t w = 0; w < prime_words_; ++w ) {
+                word_type candidates = row[w] & task.allowed[w];
+                any |= candidates;
+                shared |= candidates & used[w];
+            }
+            if( !any )
+                return std::numeric_limits<size_t>::max() / 2;
+            if( !shared ) {
+                ++bound;
+                for( size_t w = 0; w < prime_words_; ++w )
+                    used[w] |= row[w] & task.allowed[w];
+            }
+        }
+    return bound;
+}
+
+// Return the uncovered minterm which has the fewest candidates
+// Return -1 if some minterm cannot be covered any more
+int cover_solver::select_minterm(const node &task) const {
+    int selected = -1;
+    size_t fewest = std::numeric_limits<size_t>::max();
+    for( size_t mw = 0; mw < minterm_words_; ++mw )
+        for( word_type bits = uncovered_word(task.covered, mw); bits; bits &= bits - 1 ) {
+            size_t m = mw * word_bits + __builtin_ctzll(bits);
+            const word_type *row = covered_by(m);
+            size_t count = 0;
+            for( size_t w = 0; w < prime_words_; ++w )
+                count += popcount(row[w] & task.allowed[w]);
+            if( count == 0 )
+                return -1;
+            if( count < fewest ) {
+                fewest = count;
+                selected = m;
+            }
+        }
+    return selected;
+}
+
+// Size of a greedy cover of the core, used as the initial upper bound
+size_t cover_solver::greedy_bound(const node &root) const {
+    words_type covered = root.covered;
+    size_t size = 0;
+    while( count_covered(covered) != num_minterms_ ) {
+        size_t best_gain = 0;
+        int best_prime = -1;
+        for( size_t w = 0; w < prime_words_; ++w )
+            for( word_type bits = root.allowed[w]; bits; bits &= bits - 1 ) {
+                size_t p = w * word_bits + __builtin_ctzll(bits);
+                size_t gain = 0;
+                for( size_t i = 0; i < minterm_words_; ++i )
+                    gain += popcount(coverage_of(p)[i] & ~covered[i]);
+                if( best_gain < gain ) {
+                    best_gain = gain;
+                    best_prime = p;
+                }
+            }
+        if( best_prime < 0 )
+            throw std::runtime_error("cover: a minterm is not covered by any prime implicant");
+        for( size_t i = 0; i < minterm_words_; ++i )
+            covered[i] |= coverage_of(best_prime)[i];
+        ++size;
+    }
+    return size;
+}
+
+size_t cover_solver::count_covered(const words_type &covered) const {
+    size_t count = 0;
+    for( word_type word : covered )
+        count += popcount(word);
+    return count;
+}
+
+// Uncovered minterms of the w-th word, excluding the bits past the last minterm
+cover_solver::word_type cover_solver::uncovered_word(const words_type &covered, size_t w) const {
+    word_type bits = ~covered[w];
+    if( w == minterm_words_ - 1 && num_minterms_ % word_bits )
+        bits &= (word_type(1) << (num_minterms_ % word_bits)) - 1;
+    return bits;
+}
+
+
+}   // namespace quine_mccluskey
+
@@ -0,0 +1,109 @@
+#ifndef COVER_SOLVER_HPP
+#define COVER_SOLVER_HPP
+
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <boost/dynamic_bitset.hpp>
+#include "logical_expr.hpp"
+
+
+namespace quine_mccluskey {
+
+using namespace std;
+using logical_expr::counting_allocator;
+using logical_expr::counted_vector;
+
+//
+// Exact minimum cover solver
+//
+// Finds every cover of the minterms with the least number of prime implicants.
+//  1. Essential prime implicants are taken first
+//  2. The remaining cyclic core is searched by branch-and-bound twice.
+//     The first search finds the least size, pruning ties,
+//     and the second one collects every cover of that size.
+//     Subtrees near the root are spread over a work-stealing thread pool,
+//     and all the threads share one best bound.
+//     A set of minterms which share no prime implicant gives the lower bound.
+//     Idle threads sleep until a task is pushed.
+// The result is sorted, so it never depends on the scheduling of threads.
+//
+class cover_solver {
+public:
+    // Sets and covers allocate through counting_allocator like terms and tables
+    typedef boost::dynamic_bitset<unsigned long, counting_allocator<unsigned long>> bitset_type;
+    typedef counted_vector<int> cover_type;     // sorted indices of prime implicants
+
+    // coverage[i]: minterms covered by the i-th prime implicant
+    // threads: number of threads to be used (0: hardware concurrency)
+    cover_solver(const counted_vector<bitset_type> &coverage, size_t num_minterms, unsigned threads = 0);
+    ~cover_solver() {}
+
+    const counted_vector<cover_type>& solve();
+
+private:
+    // Sets of minterms and prime implicants are arrays of 64-bit words,
+    // so that they are intersected and counted without temporaries
+    typedef std::uint64_t word_type;
+    typedef counted_vector<word_type> words_type;
+    static const int word_bits = 64;
+
+    struct node {
+        words_type covered, allowed;
+        cover_type chosen;
+        int depth;
+    };
+    struct worker {
+        std::mutex mtx;
+        std::deque<node, counting_allocator<node>> tasks;
+        words_type used;    // scratch of lower_bound()
+        // covered and allowed saved by expand() at each number of chosen primes
+        words_type covered_trail, allowed_trail;
+    };
+
+    void search(node &&root);
+    void run_worker(int id);
+    bool pop_task(int id, node &task);
+    bool steal_task(int id, node &task);
+    void push_task(int id, node &&task);
+    void expand(int id, node &task);
+    void record(const cover_type &cover);
+    size_t lower_bound(const node &task, words_type &used) const;
+    int select_minterm(const node &task) const;
+    size_t greedy_bound(const node &root) const;
+    size_t count_covered(const words_type &covered) const;
+    word_type uncovered_word(const words_type &covered, size_t w) const;
+
+    const word_type* coverage_of(size_t p) const
+        { return &coverage_[p * minterm_words_]; }
+    const word_type* covered_by(size_t m) const
+        { return &covered_by_[m * prime_words_]; }
+
+    static const int spawn_depth = 6;
+
+    size_t num_primes_, num_minterms_;
+    size_t minterm_words_, prime_words_;
+    words_type coverage_;       // minterms covered by each prime implicant
+    words_type covered_by_;     // prime implicants covering each minterm
+    unsigned threads_;
+    std::atomic<size_t> best_;
+    std::atomic<long> pending_;     // tasks which are queued or being expanded
+    std::atomic<long> queued_;      // tasks which are queued
+    std::deque<worker, counting_allocator<worker>> workers_;
+    std::mutex idle_mtx_;
+    std::condition_variable idle_cv_;
+    std::mutex result_mtx_;
+    bool keep_ties_;                    // true while collecting covers of the least size
+    counted_vector<cover_type> found_;
+    counted_vector<cover_type> result_;
+};
+
+
+}   // namespace quine_mccluskey
+
+
+#endif  // COVER_SOLVER_HPP
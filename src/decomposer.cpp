@@ -0,0 +1,204 @@
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include "logical_expr.hpp"
+#include "quine_mccluskey.hpp"
+#include "decomposer.hpp"
+
+using namespace std;
+using namespace logical_expr;
+
+namespace quine_mccluskey {
+
+
+typedef decomposer::term_type term_type;
+typedef decomposer::function_type function_type;
+
+decomposer::decomposer(const function_type &func) : width_(func.term_size()) {
+    if( 30 < width_ )
+        throw std::runtime_error("decomposer: too many variables to make a truth table");
+    make_truth_table(func);
+    vector<bool> vacuous(width_, false);
+    vector<int> support;
+    for( int var = 0; var < width_; ++var ) {
+        if( is_vacuous(var) ) {
+            vacuous[var] = true;
+            vacuous_.push_back(var);
+        }
+        else
+            support.push_back(var);
+    }
+    find_symmetric_groups(support);
+    // A function which depends on no variable is a tautology
+    if( !support.empty() )
+        split(func, vacuous);
+}
+
+function_type decomposer::expand(int index, const function_type &func) const {
+    const vector<int> &vars = subproblems_[index].vars;
+    function_type expanded;
+    expanded.reserve(func.size());
+    for( const auto &term : func ) {
+        term_type full(width_);
+        for( int i = 0; i < vars.size(); ++i )
+            full[vars[i]] = term[i];
+        expanded += std::move(full);
+    }
+    return expanded;
+}
+
+vector<function_type> decomposer::simplify(unsigned threads, const string &external_dir,
+        simplifier::prime_method method) const
+{
+    if( subproblems_.empty() )
+        return vector<function_type>{ function_type(term_type(width_)) };
+
+    // At most total subproblems run at a time, each worker taking the next one.
+    // The threads left over are shared by the cover solvers of the workers
+    const unsigned total = threads ? threads : std::max(std::thread::hardware_concurrency(), 1u);
+    const unsigned num_workers = std::min<size_t>(total, subproblems_.size());
+    vector<vector<function_type>> covers(subproblems_.size());
+    vector<std::exception_ptr> errors(subproblems_.size());
+    std::atomic<size_t> next(0);
+    auto run_worker = [&](unsigned id){
+        const unsigned solver_threads = total / num_workers + (id < total % num_workers ? 1 : 0);
+        for( size_t i; (i = next++) < subproblems_.size(); ) {
+            try {
+                simplifier qm(subproblems_[i].function);
+                qm.set_num_threads(solver_threads);
+                qm.set_external_dir(external_dir);
+                qm.set_prime_method(method);
+                qm.compress_table(false);
+                for( const auto &func : qm.simplify() )
+                    covers[i].push_back(expand(i, func));
+            }
+            catch( ... ) {
+                errors[i] = std::current_exception();
+            }
+        }
+    };
+    vector<std::thread> pool;
+    for( unsigned id = 1; id < num_workers; ++id )
+        pool.emplace_back(run_worker, id);
+    run_worker(0);
+    for( auto &th : pool )
+        th.join();
+    for( const auto &error : errors )
+        if( error )
+            std::rethrow_exception(error);
+
+    // Every combination of minimum covers of subproblems is a minimum cover
+    vector<function_type> result(1);
+    for( const auto &sub_covers : covers ) {
+        vector<function_type> combined;
+        combined.reserve(result.size() * sub_covers.size());
+        for( const auto &former : result )
+            for( const auto &latter : sub_covers )
+                combined.push_back(former + latter);
+        result.swap(combined);
+    }
+    return result;
+}
+
+// Make the truth table by enumerating minterms of each term without evaluating the function
+void decomposer::make_truth_table(const function_type &func) {
+    table_.resize(size_t(1) << width_);
+    for( const auto &term : func )
+        term.for_each_minterm([&](unsigned long index){ table_.set(index); });
+}
+
+// f(var = 0) == f(var = 1)
+bool decomposer::is_vacuous(int var) const {
+    size_t bit = size_t(1) << (width_ - 1 - var);
+    for( size_t index = 0; index < table_.size(); ++index )
+        if( !(index & bit) && table_[index] != table_[index | bit] )
+            return false;
+    return true;
+}
+
+// f(var1 = 0, var2 = 1) == f(var1 = 1, var2 = 0)
+bool decomposer::is_symmetric(int var1, int var2) const {
+    size_t bit1 = size_t(1) << (width_ - 1 - var1), bit2 = size_t(1) << (width_ - 1 - var2);
+    for( size_t index = 0; index < table_.size(); ++index )
+        if( !(index & bit1) && (index & bit2) && table_[index] != table_[index ^ bit1 ^ bit2] )
+            return false;
+    return true;
+}
+
+// Symmetry of variables is an equivalence relation
+void decomposer::find_symmetric_groups(const vector<int> &vars) {
+    vector<bool> grouped(vars.size(), false);
+    for( int i = 0; i < vars.size(); ++i ) {
+        if( grouped[i] )
+            continue;
+        vector<int> group{ vars[i] };
+        for( int j = i + 1; j < vars.size(); ++j )
+            if( !grouped[j] && is_symmetric(vars[i], vars[j]) ) {
+                grouped[j] = true;
+                group.push_back(vars[j]);
+            }
+        if( 1 < group.size() )
+            symmetric_.push_back(std::move(group));
+    }
+}
+
+// Split terms into groups whose variables are disjoint, ignoring vacuous variables
+void decomposer::split(const function_type &func, const vector<bool> &vacuous) {
+    vector<int> parent(width_);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](int var){
+        while( parent[var] != var )
+            var = parent[var] = parent[parent[var]];
+        return var;
+    };
+    for( const auto &term : func ) {
+        int first = -1;
+        for( int i = 0; i < width_; ++i ) {
+            if( vacuous[i] || term[i] == dont_care )
+                continue;
+            if( first < 0 )
+                first = i;
+            else
+                parent[find(i)] = find(first);
+        }
+    }
+
+    // Subproblems are ordered by their first variables
+    vector<int> component(width_, -1), index_of(width_, -1);
+    for( int var = 0; var < width_; ++var ) {
+        if( vacuous[var] )
+            continue;
+        int root = find(var);
+        if( index_of[root] < 0 ) {
+            index_of[root] = subproblems_.size();
+            subproblems_.push_back(subproblem());
+        }
+        component[var] = index_of[root];
+        subproblems_[component[var]].vars.push_back(var);
+    }
+
+    for( const auto &term : func ) {
+        int var = 0;
+        while( var < width_ && (vacuous[var] || term[var] == dont_care) )
+            ++var;
+        // A term which consists of vacuous variables only never remains,
+        // since the function would be a tautology
+        if( var == width_ )
+            continue;
+        subproblem &sub = subproblems_[component[var]];
+        term_type projected(sub.vars.size());
+        for( int i = 0; i < sub.vars.size(); ++i )
+            projected[i] = term[sub.vars[i]];
+        sub.function += std::move(projected);
+    }
+}
+
+
+}   // namespace quine_mccluskey
+
@@ -0,0 +1,70 @@
+#ifndef DECOMPOSER_HPP
+#define DECOMPOSER_HPP
+
+
+#include <vector>
+#include <string>
+#include <boost/dynamic_bitset.hpp>
+#include "logical_expr.hpp"
+#include "quine_mccluskey.hpp"
+
+
+namespace quine_mccluskey {
+
+using namespace std;
+using namespace logical_expr;
+
+//
+// Problem decomposition before simplifying
+//
+//  [*] Vacuous variables, on which the function does not depend, are removed
+//  [*] Terms are split into groups whose variables are disjoint.
+//      f = g(X) + h(Y) is simplified as g and h separately in parallel,
+//      and every minimum cover of f is a pair of minimum covers of g and h
+//  [*] Groups of symmetric variables are detected
+//      (they are reported but do not reduce the problem)
+//
+class decomposer {
+public:
+    typedef simplifier::term_type term_type;
+    typedef logical_function<term_type> function_type;
+
+    struct subproblem {
+        vector<int> vars;           // variables of the original function
+        function_type function;     // function of vars only
+    };
+
+    explicit decomposer(const function_type &func);
+    ~decomposer() {}
+
+    const vector<int>& get_vacuous_vars() const { return vacuous_; }
+    const vector<vector<int>>& get_symmetric_groups() const { return symmetric_; }
+    const vector<subproblem>& get_subproblems() const { return subproblems_; }
+
+    // Expand a function of the index-th subproblem to the original variables
+    function_type expand(int index, const function_type &func) const;
+    // Simplify subproblems in parallel and return the combination of their minimum covers
+    // At most threads (0: hardware concurrency) threads run in total,
+    // and the subproblems are taken one by one by that many workers at most
+    vector<function_type> simplify(unsigned threads = 0, const string &external_dir = "",
+            simplifier::prime_method method = simplifier::automatic) const;
+
+private:
+    void make_truth_table(const function_type &func);
+    bool is_vacuous(int var) const;
+    bool is_symmetric(int var1, int var2) const;
+    void find_symmetric_groups(const vector<int> &vars);
+    void split(const function_type &func, const vector<bool> &vacuous);
+
+    size_t width_;
+    boost::dynamic_bitset<> table_;     // table_[i]: value of minterm i
+    vector<int> vacuous_;
+    vector<vector<int>> symmetric_;
+    vector<subproblem> subproblems_;
+};
+
+
+}   // namespace quine_mccluskey
+
+
+#endif  // DECOMPOSER_HPP
@@ -0,0 +1,286 @@
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <boost/format.hpp>
+#include "external_table.hpp"
+
+using namespace std;
+
+namespace quine_mccluskey {
+
+
+// Definitions of the constants, which std::min() takes by reference
+const size_t external_table::run_size;
+const size_t external_table::buffer_size;
+
+static std::runtime_error system_error(const string &what, const string &path) {
+    return std::runtime_error(
+        (boost::format("external_table: %1% %2%: %3%") % what % path % std::strerror(errno)).str()
+    );
+}
+
+static bool record_less(const external_table::record &a, const external_table::record &b) {
+    if( a.mask != b.mask ) return a.mask < b.mask;
+    if( a.ones != b.ones ) return a.ones < b.ones;
+    return a.value < b.value;
+}
+
+static bool record_same(const external_table::record &a, const external_table::record &b) {
+    return (a.mask == b.mask && a.value == b.value);
+}
+
+external_table::external_table(const string &path, int width)
+    : path_(path), runs_path_(path + ".runs"), width_(width), fd_(-1), runs_fd_(-1), data_(nullptr), size_(0)
+{
+    if( width_ < 1 || 64 < width_ )
+        throw std::runtime_error("external_table: width must be from 1 to 64");
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if( fd_ < 0 )
+        throw system_error("cannot open", path_);
+}
+
+// The files never remain even if compression is interrupted by an exception
+external_table::~external_table() {
+    unmap();
+    if( 0 <= fd_ ) {
+        ::close(fd_);
+        ::unlink(path_.c_str());
+    }
+    if( 0 <= runs_fd_ ) {
+        ::close(runs_fd_);
+        ::unlink(runs_path_.c_str());
+    }
+}
+
+void external_table::append(const record &rec) {
+    if( buffer_.empty() )
+        buffer_.reserve(buffer_size);
+    buffer_.push_back(rec);
+    if( buffer_.size() == run_size )
+        spill_run();
+}
+
+void external_table::seal() {
+    if( run_ends_.empty() ) {
+        // The level fits in a run, which is sorted in memory and written once
+        std::sort(buffer_.begin(), buffer_.end(), record_less);
+        buffer_.erase(std::unique(buffer_.begin(), buffer_.end(), record_same), buffer_.end());
+        write_records(fd_, path_, buffer_.data(), buffer_.size());
+    }
+    else {
+        spill_run();
+        merge_runs();
+    }
+    counted_vector<record>().swap(buffer_);
+    map();
+}
+
+// Combine each pair of adjacent groups (mask, k 1s) and (mask, k+1 1s) by merge join.
+// For each variable of mask, lhs and lhs with the variable set to 1 are
+// both in ascending order, so the two groups are scanned once per variable.
+size_t external_table::combine(external_table &next, bool printable) {
+    size_t count = 0;
+    size_t lower = 0;
+    while( lower < size_ ) {
+        // [lower, upper): terms which have the same mask and the same number of 1s
+        // [upper, last): the group next to it
+        const uint64_t mask = data_[lower].mask;
+        size_t upper = lower;
+        while( upper < size_ && data_[upper].mask == mask && data_[upper].ones == data_[lower].ones )
+            ++upper;
+        size_t last = upper;
+        while( last < size_ && data_[last].mask == mask && data_[last].ones == data_[lower].ones + 1 )
+            ++last;
+        for( uint64_t bits = mask; bits && upper < last; bits &= bits - 1 ) {
+            const uint64_t bit = bits & (~bits + 1);
+            size_t j = upper;
+            for( size_t i = lower; i < upper && j < last; ++i ) {
+                record &lhs = data_[i];
+                if( lhs.value & bit )
+                    continue;
+                const uint64_t value = lhs.value | bit;
+                while( j < last && data_[j].value < value )
+                    ++j;
+                if( j == last || data_[j].value != value )
+                    continue;
+                record &rhs = data_[j];
+                record term = make_record(lhs.value, mask & ~bit);
+                if( printable )
+                    cout << "COMPRESS(" << to_string(lhs, width_) << ", " << to_string(rhs, width_)
+                         << ") = " << to_string(term, width_) << endl;
+                next.append(term);
+                lhs.used = rhs.used = 1;
+                ++count;
+            }
+        }
+        lower = upper;
+    }
+    next.seal();
+    return count;
+}
+
+void external_table::collect_unused(counted_vector<record> &primes) const {
+    for( size_t i = 0; i < size_; ++i )
+        if( !data_[i].used )
+            primes.push_back(data_[i]);
+}
+
+void external_table::remove() {
+    unmap();
+    if( 0 <= fd_ ) {
+        ::close(fd_);
+        fd_ = -1;
+        ::unlink(path_.c_str());
+    }
+    size_ = 0;
+}
+
+external_table::record external_table::make_record(uint64_t value, uint64_t mask) {
+    record rec = { value & mask, mask, static_cast<uint32_t>(__builtin_popcountll(value & mask)), 0 };
+    return rec;
+}
+
+string external_table::to_string(const record &rec, int width) {
+    string str(width, 'x');
+    for( int i = 0; i < width; ++i ) {
+        uint64_t bit = uint64_t(1) << (width - 1 - i);
+        if( rec.mask & bit )
+            str[i] = (rec.value & bit) ? '1' : '0';
+    }
+    return str;
+}
+
+// Sort and unique the current run, and append it to the file of runs
+void external_table::spill_run() {
+    if( runs_fd_ < 0 ) {
+        runs_fd_ = ::open(runs_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+        if( runs_fd_ < 0 )
+            throw system_error("cannot open", runs_path_);
+    }
+    std::sort(buffer_.begin(), buffer_.end(), record_less);
+    buffer_.erase(std::unique(buffer_.begin(), buffer_.end(), record_same), buffer_.end());
+    write_records(runs_fd_, runs_path_, buffer_.data(), buffer_.size());
+    run_ends_.push_back((run_ends_.empty() ? 0 : run_ends_.back()) + buffer_.size());
+    buffer_.clear();
+}
+
+// k-way merge of the sorted runs into the file, removing duplicates
+// Each run is read sequentially through a buffer of its own
+void external_table::merge_runs() {
+    struct cursor {
+        size_t next, end;       // records of the run not read yet
+        counted_vector<record> buffer;
+        size_t pos;
+    };
+    counted_vector<cursor> runs(run_ends_.size());
+    counted_vector<int> heap;
+    auto refill = [&](cursor &run){
+        run.buffer.resize(std::min(buffer_size, run.end - run.next));
+        read_records(runs_fd_, runs_path_, run.next, run.buffer.size(), run.buffer.data());
+        run.next += run.buffer.size();
+        run.pos = 0;
+        return !run.buffer.empty();
+    };
+    // The heap is ordered so that its front is the run of the least record
+    auto greater = [&](int a, int b){
+        return record_less(runs[b].buffer[runs[b].pos], runs[a].buffer[runs[a].pos]);
+    };
+    for( int i = 0; i < runs.size(); ++i ) {
+        runs[i].next = i ? run_ends_[i - 1] : 0;
+        runs[i].end = run_ends_[i];
+        if( refill(runs[i]) )
+            heap.push_back(i);
+    }
+    std::make_heap(heap.begin(), heap.end(), greater);
+
+    counted_vector<record> output;
+    output.reserve(buffer_size);
+    record last;
+    bool has_last = false;
+    while( !heap.empty() ) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        cursor &run = runs[heap.back()];
+        const record &rec = run.buffer[run.pos];
+        if( !has_last || !record_same(last, rec) ) {
+            last = rec;
+            has_last = true;
+            output.push_back(rec);
+            if( output.size() == buffer_size ) {
+                write_records(fd_, path_, output.data(), output.size());
+                output.clear();
+            }
+        }
+        if( ++run.pos < run.buffer.size() || refill(run) )
+            std::push_heap(heap.begin(), heap.end(), greater);
+        else
+            heap.pop_back();
+    }
+    write_records(fd_, path_, output.data(), output.size());
+
+    ::close(runs_fd_);
+    runs_fd_ = -1;
+    ::unlink(runs_path_.c_str());
+    run_ends_.clear();
+}
+
+void external_table::write_records(int fd, const string &path, const record *records, size_t count) {
+    const char *ptr = reinterpret_cast<const char *>(records);
+    size_t rest = count * sizeof(record);
+    while( rest ) {
+        ssize_t written = ::write(fd, ptr, rest);
+        if( written < 0 ) {
+            if( errno == EINTR ) continue;
+            throw system_error("cannot write", path);
+        }
+        ptr += written;
+        rest -= written;
+    }
+}
+
+// Read count records from offset (in records)
+void external_table::read_records(int fd, const string &path, size_t offset, size_t count, record *records) {
+    char *ptr = reinterpret_cast<char *>(records);
+    size_t done = 0, total = count * sizeof(record);
+    while( done < total ) {
+        ssize_t got = ::pread(fd, ptr + done, total - done, offset * sizeof(record) + done);
+        if( got < 0 ) {
+            if( errno == EINTR ) continue;
+            throw system_error("cannot read", path);
+        }
+        if( got == 0 )
+            throw std::runtime_error("external_table: unexpected end of " + path);
+        done += got;
+    }
+}
+
+void external_table::map() {
+    off_t length = ::lseek(fd_, 0, SEEK_END);
+    if( length < 0 )
+        throw system_error("cannot seek", path_);
+    size_ = length / sizeof(record);
+    if( size_ == 0 )
+        return;
+    void *addr = ::mmap(nullptr, size_ * sizeof(record), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if( addr == MAP_FAILED )
+        throw system_error("cannot map", path_);
+    ::madvise(addr, size_ * sizeof(record), MADV_SEQUENTIAL);
+    data_ = static_cast<record *>(addr);
+}
+
+void external_table::unmap() {
+    if( data_ )
+        ::munmap(data_, size_ * sizeof(record));
+    data_ = nullptr;
+}
+
+
+}   // namespace quine_mccluskey
+
@@ -0,0 +1,87 @@
+#ifndef EXTERNAL_TABLE_HPP
+#define EXTERNAL_TABLE_HPP
+
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "logical_expr.hpp"
+
+
+namespace quine_mccluskey {
+
+using namespace std;
+using logical_expr::counted_vector;
+
+//
+// A level of the compression table stored in a file
+//
+// Terms are fixed-size records sorted by (mask, number of 1s, value)
+// and the file is accessed through mmap, so a level does not have to fit in memory.
+// A level is sorted by external merge sort: appended terms are sorted
+// in memory run by run, spilled to a temporary file, and merged sequentially.
+// Two groups to be combined are adjacent in the file,
+// and combining them is a merge join, which scans both groups sequentially.
+//  1. append()     // append terms to the current run
+//  2. seal()       // merge the sorted runs into the file, and map the file
+//  3. combine()    // combine adjacent groups into the next level
+// The files are deleted by remove() or the destructor.
+//
+class external_table {
+public:
+    // The i-th variable of a term is bit (width - 1 - i),
+    // so that the value of a minterm is its index
+    struct record {
+        uint64_t value;     // 1 if the variable is true
+        uint64_t mask;      // 1 if the variable is not don't care
+        uint32_t ones;      // number of true variables
+        uint32_t used;      // nonzero if combined into the next level
+    };
+
+    external_table(const string &path, int width);
+    ~external_table();
+
+    size_t size() const { return size_; }
+    int width() const { return width_; }
+    const string& path() const { return path_; }
+
+    void append(const record &rec);
+    void seal();
+    // Combine the terms into next and return the number of combinations
+    size_t combine(external_table &next, bool printable = false);
+    // Append the terms which were not combined to primes
+    void collect_unused(counted_vector<record> &primes) const;
+    // Unmap and delete the file
+    void remove();
+
+    static record make_record(uint64_t value, uint64_t mask);
+    static string to_string(const record &rec, int width);
+
+private:
+    external_table(const external_table &) = delete;
+    external_table& operator=(const external_table &) = delete;
+
+    void spill_run();
+    void merge_runs();
+    static void write_records(int fd, const string &path, const record *records, size_t count);
+    static void read_records(int fd, const string &path, size_t offset, size_t count, record *records);
+    void map();
+    void unmap();
+
+    static const size_t run_size = size_t(1) << 20;    // records sorted in memory at a time
+    static const size_t buffer_size = 4096;            // records read or written at a time
+
+    string path_, runs_path_;
+    int width_;
+    int fd_, runs_fd_;
+    record *data_;
+    size_t size_;
+    counted_vector<record> buffer_;     // the current run
+    counted_vector<size_t> run_ends_;   // end of each run in the file of runs
+};
+
+
+}   // namespace quine_mccluskey
+
+
+#endif  // EXTERNAL_TABLE_HPP
@@ -11,12 +11,17 @@
 #include <stdexcept>
 #include <regex>
 #include <cmath>
+#include <cctype>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <boost/format.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/call_traits.hpp>
 #include <boost/dynamic_bitset.hpp>
 #include <boost/io/ios_state.hpp>
 #include <boost/optional.hpp>
+#include <boost/container/small_vector.hpp>
 //#include <boost/logic/tribool.hpp>
 
 //
@@ -31,10 +36,54 @@ using namespace std;
 /*thread_local*/static const boost::optional<bool> dont_care = boost::none;
 // static const boost::logic::tribool dont_care = indeterminated; better than optional<bool>
 
-// expr_mode is not used now. 
+// Mode of function_parser (verilog_expr is not supported now)
 enum expr_mode { alphabet_expr, verilog_expr, truth_table };
 
+// Minterms and don't cares parsed in truth_table mode
+struct minterm_list {
+    string vars;
+    vector<unsigned long> minterms, dont_cares;
+};
+
+//
+// Allocation counter
+// Terms, functions, compression tables and the sets of cover_solver
+// allocate through counting_allocator,
+// so that allocation_count() tells how many times the data path allocated
+//
+inline std::atomic<std::size_t>& allocation_counter() {
+    static std::atomic<std::size_t> counter(0);
+    return counter;
+}
+inline std::size_t allocation_count() { return allocation_counter().load(); }
+inline void reset_allocation_count() { allocation_counter() = 0; }
+
+template<typename T>
+class counting_allocator {
+public:
+    typedef T value_type;
+    template<typename U> struct rebind { typedef counting_allocator<U> other; };
+    counting_allocator() noexcept {}
+    template<typename U>
+    counting_allocator(const counting_allocator<U> &) noexcept {}
+    // The counter orders nothing, so threads never wait on each other to count
+    T* allocate(std::size_t n) {
+        allocation_counter().fetch_add(1, std::memory_order_relaxed);
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T *p, std::size_t n) noexcept
+        { std::allocator<T>().deallocate(p, n); }
+    template<typename U>
+    bool operator==(const counting_allocator<U> &) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const counting_allocator<U> &) const noexcept { return false; }
+};
+
+template<typename T>
+using counted_vector = vector<T, counting_allocator<T>>;
+
 // argument generating iterator for logical_function
+// The argument is updated in place, so iterating never allocates
 class arg_gen_iterator {
 public:
     typedef boost::dynamic_bitset<> value_type;
@@ -42,17 +91,13 @@ public:
     arg_gen_iterator(int width, int val) 
         : width_(width), current_val_(val), value_(width, val) {}
     this_type& operator++() {
-        value_type tmp(width_, current_val_ + 1);
-        value_.swap(tmp);   // never throw any exceptions
-        ++current_val_;
+        assign(++current_val_);
         return *this;
     }
     this_type operator++(int)
         { this_type before = *this; ++*this; return before; }
     this_type& operator--() {
-        value_type tmp(width_, current_val_ - 1);
-        value_.swap(tmp);
-        --current_val_;
+        assign(--current_val_);
         return *this;
     }
     this_type operator--(int)
@@ -67,6 +112,10 @@ public:
         { return !(*this == it); }
     const value_type& operator*() const { return value_; }
 private:
+    void assign(int val) {
+        for( int i = 0; i < width_; ++i )
+            value_[i] = (val >> i) & 1;
+    }
     const int width_;
     int current_val_;
     value_type value_;
@@ -88,6 +137,9 @@ private:
 //
 // * String to be parsed has to be in the following form:
 // * ${Function-Name}(Variables-divided-by-',' ...) = ${TERMS} + ...
+// * In truth_table mode, ${TERMS} is replaced with one of the following
+// *   m(${MINTERMS-divided-by-','}) + d(${DONT-CARES-divided-by-','})
+// *   0x${HEX-TRUTH-TABLE} + d(...) or 0b${BINARY-TRUTH-TABLE} + d(...)
 // * White spaces will be ignored
 // * Default character to invert a variable is '~' (first template parameter)
 // See README for more information about parsing
@@ -105,6 +157,8 @@ public:
     const string& function_name() const { return func_name_; }
 
     result_type parse() {
+        if( mode != alphabet_expr )
+            throw std::logic_error("expr: parse() is only for alphabet_expr mode");
         auto untokenized = scanner();
         auto token = tokenizer(untokenized);
         boost::optional<char> undecl = use_undeclared_vars(token.second, token.first);
@@ -114,7 +168,62 @@ public:
             );
         if( !is_sequence(token.first, first_char_) )   
             throw std::runtime_error("expr: used variables are not sequence");
-        return std::move(token);
+        return token;
+    }
+
+    // Parse a truth table or a list of minterms without evaluating terms
+    minterm_list parse_minterms() {
+        if( mode != truth_table )
+            throw std::logic_error("expr: parse_minterms() is only for truth_table mode");
+        if( expr_.empty() )
+            throw std::runtime_error("expr: Expression is empty, aborted");
+        // White spaces between alphanumeric characters are kept (and rejected),
+        // so that "m(1 2)" or "0x F F" is never read as "m(12)" or "0xFF"
+        auto is_space = [](char c){ return std::isspace(static_cast<unsigned char>(c)) != 0; };
+        auto is_alnum = [](char c){ return std::isalnum(static_cast<unsigned char>(c)) != 0; };
+        string expr_with_nospaces;
+        expr_with_nospaces.reserve(expr_.size());
+        for( auto it = expr_.begin(); it != expr_.end(); ) {
+            if( !is_space(*it) ) {
+                expr_with_nospaces += *it++;
+                continue;
+            }
+            it = std::find_if_not(it, expr_.end(), is_space);
+            if( !expr_with_nospaces.empty() && it != expr_.end()
+                    && is_alnum(expr_with_nospaces.back()) && is_alnum(*it) )
+                expr_with_nospaces += ' ';
+        }
+        // Only the declaration is matched with regex.
+        // The table or the list may be too long for std::regex, so it is scanned by hand
+        std::regex reg("([A-Za-z_-]+)\\((((\\s*[A-Za-z],)*)([A-Za-z]))\\)=");
+        std::smatch result;
+        if( !std::regex_search(expr_with_nospaces, result, reg, std::regex_constants::match_continuous) )
+            throw mismatch_error();
+        func_name_ = result[1];
+        minterm_list list;
+        list.vars = tokenizer(vector<string>{result[2], ""}).first;
+        if( !is_sequence(list.vars, first_char_) )
+            throw std::runtime_error("expr: used variables are not sequence");
+        const unsigned long table_size = 1ul << list.vars.size();
+        char_iterator it = result[0].second, end = expr_with_nospaces.cend();
+        if( skip(it, end, "0x") )
+            list.minterms = table_to_minterms(it, end, 4, table_size);
+        else if( skip(it, end, "0b") )
+            list.minterms = table_to_minterms(it, end, 1, table_size);
+        else if( skip(it, end, "m(") )
+            list.minterms = index_to_minterms(it, end, table_size);
+        else
+            throw mismatch_error();
+        if( skip(it, end, "+d(") )
+            list.dont_cares = index_to_minterms(it, end, table_size);
+        if( it != end )
+            throw mismatch_error();
+        for( auto dc : list.dont_cares )
+            if( std::binary_search(list.minterms.begin(), list.minterms.end(), dc) )
+                throw std::runtime_error(
+                    (boost::format("expr: %1% is both a minterm and a don't care") % dc).str()
+                );
+        return list;
     }
 
     vector<string> scanner() {
@@ -157,7 +266,7 @@ public:
     }
 
     static boost::optional<char> use_undeclared_vars(const vector<string> &terms, const string &vars) {
-        for( auto term : terms )
+        for( const auto &term : terms )
           for( auto used_var : term )
             if( used_var != inverter && vars.find(used_var, 0) == string::npos )
               return (used_var);
@@ -165,6 +274,83 @@ public:
     }
 
 private:
+    typedef string::const_iterator char_iterator;
+
+    static std::runtime_error mismatch_error() {
+        return std::runtime_error("expr: Input string does not match the correct form");
+    }
+
+    // Advance it past token if the rest of the string starts with it
+    static bool skip(char_iterator &it, char_iterator end, const char *token) {
+        char_iterator next = it;
+        for( ; *token; ++token, ++next )
+            if( next == end || *next != *token )
+                return false;
+        it = next;
+        return true;
+    }
+
+    // Return the value of a hexadecimal digit, or -1
+    static int digit_value(char c) {
+        if( '0' <= c && c <= '9' ) return c - '0';
+        if( 'a' <= c && c <= 'f' ) return c - 'a' + 10;
+        if( 'A' <= c && c <= 'F' ) return c - 'A' + 10;
+        return -1;
+    }
+
+    // Return sorted minterms of a truth table whose last digit is of minterm 0
+    // it is advanced past the digits
+    static vector<unsigned long> table_to_minterms(char_iterator &it, char_iterator end,
+            int digit_bits, unsigned long table_size)
+    {
+        char_iterator first = it;
+        while( it != end && 0 <= digit_value(*it) && digit_value(*it) < (1 << digit_bits) )
+            ++it;
+        if( first == it )
+            throw mismatch_error();
+        vector<unsigned long> minterms;
+        unsigned long index = 0;
+        for( char_iterator digit_it = it; digit_it != first; ) {
+            unsigned long digit = digit_value(*--digit_it);
+            for( int bit = 0; bit < digit_bits; ++bit, ++index ) {
+                if( !(digit >> bit & 1) )
+                    continue;
+                if( table_size <= index )
+                    throw std::runtime_error("expr: truth table is larger than declared variables");
+                minterms.push_back(index);
+            }
+        }
+        return minterms;
+    }
+
+    // Return sorted and unique minterms of a list like "1,3,7)"
+    // it is advanced past the closing parenthesis
+    static vector<unsigned long> index_to_minterms(char_iterator &it, char_iterator end, unsigned long table_size) {
+        vector<unsigned long> minterms;
+        while( it != end && *it != ')' ) {
+            if( !minterms.empty() && !skip(it, end, ",") )
+                throw mismatch_error();
+            char_iterator first = it;
+            unsigned long index = 0;
+            // Stop accumulating once out of range, so that it never overflows
+            for( ; it != end && '0' <= *it && *it <= '9'; ++it )
+                if( index < table_size )
+                    index = index * 10 + (*it - '0');
+            if( first == it )
+                throw mismatch_error();
+            if( table_size <= index )
+                throw std::runtime_error(
+                    (boost::format("expr: minterm %1% is out of range") % string(first, it)).str()
+                );
+            minterms.push_back(index);
+        }
+        if( !skip(it, end, ")") )
+            throw mismatch_error();
+        std::sort(minterms.begin(), minterms.end());
+        minterms.erase(std::unique(minterms.begin(), minterms.end()), minterms.end());
+        return minterms;
+    }
+
     string expr_, func_name_;
     char first_char_;
 };
@@ -209,6 +395,9 @@ class logical_term {
 public:
     typedef boost::optional<bool> value_type;    
     typedef boost::dynamic_bitset<> arg_type;
+    // Terms up to inline_size variables are stored without allocation
+    static const std::size_t inline_size = 32;
+    typedef boost::container::small_vector<value_type, inline_size, counting_allocator<value_type>> storage_type;
     typedef logical_term<Property_> this_type;
     typedef std::size_t size_t;
     typedef Property_ property_type;
@@ -219,9 +408,17 @@ public:
     template<typename Property>
     explicit logical_term(const logical_term<Property> &term) 
         { construct_from(term); }
-    explicit logical_term(const arg_type &arg) {
-        for( int i = arg.size() - 1; 0 <= i; --i )
-            term_.push_back(arg[i]);
+    explicit logical_term(const arg_type &arg) : term_(arg.size()) {
+        for( int i = 0; i < arg.size(); ++i )
+            term_[i] = static_cast<bool>(arg[arg.size() - 1 - i]);
+    }
+
+    // Make the minterm of index, whose first variable is the most significant bit
+    static this_type from_index(int width, unsigned long index) {
+        this_type term(width);
+        for( int i = 0; i < width; ++i )
+            term.term_[i] = static_cast<bool>((index >> (width - 1 - i)) & 1);
+        return term;
     }
 
     template<typename Property>
@@ -252,6 +449,17 @@ public:
                 [value](const value_type &b){ return (b != dont_care && *b == value); }));
     }
 
+    // Return true if every argument which satisfies term satisfies this term
+    template<typename Property>
+    bool contains(const logical_term<Property> &term) const {
+        if( !size_check(term) )
+            throw std::runtime_error(size_error_msg);
+        for( int i = 0; i < size(); ++i )
+            if( term_[i] != dont_care && term_[i] != term[i] )
+                return false;
+        return true;
+    }
+
     size_t diff_size(const this_type &term) const {
         if( !size_check(term) )
             throw std::runtime_error(size_error_msg);
@@ -274,6 +482,40 @@ public:
     bool operator()(const arg_type &arg) const 
         { return calculate(arg); }
 
+    // Call func with the index of each minterm which satisfies this term
+    // The first variable is the most significant bit of an index
+    template<typename Function>
+    void for_each_minterm(Function func) const {
+        unsigned long base = 0, free_bits = 0;
+        for( int i = 0; i < size(); ++i ) {
+            unsigned long bit = 1ul << (size() - 1 - i);
+            if( term_[i] == dont_care )
+                free_bits |= bit;
+            else if( *term_[i] )
+                base |= bit;
+        }
+        // Enumerate the subsets of free_bits in ascending order
+        unsigned long sub = 0;
+        do {
+            func(base | sub);
+            sub = (sub - free_bits) & free_bits;
+        } while( sub );
+    }
+
+    // Bit-sliced evaluation of many arguments at once
+    // Bit k of vars[i] is the i-th variable of the k-th argument,
+    // and bit k of the result is the value for the k-th argument.
+    // Word is an unsigned integer or a vector type of the compiler (SIMD)
+    // The bits past the number of arguments are garbage; the caller masks them out
+    template<typename Word>
+    Word calculate_sliced(const Word *vars) const {
+        Word ret = ~Word();
+        for( int i = 0; i < term_.size(); ++i )
+            if( term_[i] != dont_care )
+                ret &= (*term_[i] ? vars[i] : ~vars[i]);
+        return ret;
+    }
+
     value_type& operator[](int index)
         { return term_[index]; }
     const value_type& operator[](int index) const
@@ -309,7 +551,7 @@ public:
 
 private:
     static const std::string size_error_msg;
-    vector<value_type> term_;
+    storage_type term_;
     property_type property_;
 };
 template<typename Property>
@@ -357,7 +599,7 @@ logical_term<Property> onebit_minimize(const logical_term<Property> &a, const lo
     for( int i = 0; i < term.size(); ++i )
         if( term[i] != b[i] )
             term[i] = dont_care;
-    return std::move(term);
+    return term;
 }
 
 // Return minimized term which has pval as its property value
@@ -370,7 +612,58 @@ logical_term<Property> onebit_minimize(
 {
     logical_term<Property> term = onebit_minimize(a, b);
     property_set(term, pval);
-    return std::move(term);
+    return term;
+}
+
+
+//
+// Consensus of term a and b
+// Return none unless exactly one variable is true in a term and false in the other
+//
+template<typename Property>
+boost::optional<logical_term<Property>> consensus(const logical_term<Property> &a, const logical_term<Property> &b)
+{
+    if( a.size() != b.size() )
+        throw std::runtime_error("tried to make a consensus of terms which are not same size");
+    int opposite = -1;
+    for( int i = 0; i < a.size(); ++i ) {
+        if( a[i] == dont_care || b[i] == dont_care || a[i] == b[i] )
+            continue;
+        if( 0 <= opposite )
+            return boost::none;
+        opposite = i;
+    }
+    if( opposite < 0 )
+        return boost::none;
+    logical_term<Property> term(a);
+    for( int i = 0; i < term.size(); ++i )
+        if( term[i] == dont_care )
+            term[i] = b[i];
+    term[opposite] = dont_care;
+    return term;
+}
+
+
+//
+// Transpose arguments to bit-sliced variables for calculate_sliced()
+// Bit (width - 1 - i) of args[k] is the i-th variable of the k-th argument,
+// so that an argument is the index of a minterm. count and width must be 64 or less
+// The bits of vars past count are 0, so the bits of the result past count
+// hold the value for the minterm 0 instead of any argument
+//
+inline void slice_arguments(const std::uint64_t *args, std::size_t count, std::size_t width, std::uint64_t *vars)
+{
+    if( 64 < count )
+        throw std::runtime_error("cannot slice more than 64 arguments into a word");
+    if( 64 < width )
+        throw std::runtime_error("cannot slice arguments of more than 64 variables");
+    for( std::size_t i = 0; i < width; ++i ) {
+        const std::size_t shift = width - 1 - i;
+        std::uint64_t word = 0;
+        for( std::size_t k = 0; k < count; ++k )
+            word |= ((args[k] >> shift) & 1) << k;
+        vars[i] = word;
+    }
 }
 
 
@@ -383,14 +676,21 @@ public:
     typedef std::size_t size_t;
     typedef TermType value_type;
     typedef boost::dynamic_bitset<> arg_type;
-    typedef typename vector<value_type>::iterator iterator;
-    typedef typename vector<value_type>::const_iterator const_iterator;
+    typedef counted_vector<value_type> storage_type;
+    typedef typename storage_type::iterator iterator;
+    typedef typename storage_type::const_iterator const_iterator;
     typedef logical_function<TermType> this_type;
 
     logical_function() {}
     explicit logical_function(const TermType &term) { add(term); }
+    explicit logical_function(TermType &&term) { add(std::move(term)); }
+    logical_function(const this_type &) = default;
+    logical_function(this_type &&) = default;
     ~logical_function() {}
 
+    this_type& operator=(const this_type &) = default;
+    this_type& operator=(this_type &&) = default;
+
     iterator begin()             { return func_.begin(); }
     const_iterator begin() const { return func_.begin(); }
     iterator end()               { return func_.end(); }
@@ -407,22 +707,28 @@ public:
     }
     void add(const TermType &term)
         { func_.push_back(term); }
-
-    void add(const this_type &func) {
-        vector<TermType> tmp(func_);
-        for( auto term : func )
-            tmp.push_back(term);
-        func_ = std::move(tmp);
+    void add(TermType &&term)
+        { func_.push_back(std::move(term)); }
+
+    void add(const this_type &func)
+        { func_.insert(func_.end(), func.begin(), func.end()); }
+    void add(this_type &&func) {
+        if( func_.empty() )
+            func_.swap(func.func_);
+        else
+            func_.insert(func_.end(), std::make_move_iterator(func.begin()), std::make_move_iterator(func.end()));
     }
 
+    void reserve(int n)
+        { func_.reserve(n); }
     void clear()
         { func_.clear(); }
     
     bool calculate(const arg_type &arg) const {
-        bool ret = false;
-        for( auto term : func_ )
-            ret = ret || term(arg);
-        return ret;
+        for( const auto &term : func_ )
+            if( term(arg) )
+                return true;
+        return false;
     }
 
     bool is_same(const this_type &func) const {
@@ -436,6 +742,21 @@ public:
         return true;
     }
 
+    // Bit-sliced evaluation (see logical_term::calculate_sliced())
+    template<typename Word>
+    Word calculate_sliced(const Word *vars) const {
+        Word ret = Word();
+        for( const auto &term : func_ )
+            ret |= term.calculate_sliced(vars);
+        return ret;
+    }
+    template<typename Word, typename Allocator>
+    Word calculate_sliced(const vector<Word, Allocator> &vars) const {
+        if( vars.size() != term_size() )
+            throw std::runtime_error("number of bit-sliced variables differs from term size");
+        return calculate_sliced(vars.data());
+    }
+
     bool operator()(const arg_type &arg) const
         { return calculate(arg); }
     value_type& operator[](int index)
@@ -444,24 +765,30 @@ public:
         { return func_[index]; }
     
     // The expression like "term + term = func" is not allowed
-    const logical_function operator+(const TermType &term) {
+    logical_function operator+(const TermType &term) const {
         logical_function ret(*this);
         ret += term;
         return ret;
     }
 
-    const logical_function operator+(const logical_function<TermType> &func) {
-        logical_function ret(*this);
+    logical_function operator+(const logical_function<TermType> &func) const {
+        logical_function ret;
+        ret.reserve(size() + func.size());
+        ret += *this;
         ret += func;
         return ret;
     }
     
     logical_function& operator+=(const TermType &term)
         { add(term); return *this; }
+    logical_function& operator+=(TermType &&term)
+        { add(std::move(term)); return *this; }
     logical_function& operator+=(const logical_function &func)
         { add(func); return *this; }
+    logical_function& operator+=(logical_function &&func)
+        { add(std::move(func)); return *this; }
     friend ostream& operator<<(ostream &os, const logical_function &bf) {
-        for( auto term : bf.func_ )
+        for( const auto &term : bf.func_ )
             os << term << " ";
         return os;
     }
@@ -476,7 +803,7 @@ public:
     }
 
 private:
-    vector<TermType> func_;
+    storage_type func_;
 };
 
 
@@ -5,9 +5,14 @@
 #include <stdexcept>
 #include <cmath>
 #include <cstdlib>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <boost/io/ios_state.hpp>
 #include <boost/program_options.hpp>
 #include "logical_expr.hpp"
 #include "quine_mccluskey.hpp"
+#include "decomposer.hpp"
 
 using namespace std;
 
@@ -51,16 +56,79 @@ void print_truth_table(
         cout << ((i == f.term_size() + 1) ? '|' : '-');
     cout << endl;
     logical_expr::arg_generator<> generator(0, std::pow(2, f.term_size()), f.term_size());
-    for( auto arg : generator )
+    for( const auto &arg : generator )
         cout << arg << " |  " << f(arg) << endl;
 }
 
+// Print a function as a branchless C++ function comparing each term by mask
+// Bit (n - 1 - i) of the argument is the value of the i-th variable
+template<typename TermType>
+void print_cpp_function(
+        const logical_expr::logical_function<TermType> &func,
+        char first_char = 'A', const string &funcname = "f")
+{
+    if( 64 < func.term_size() )
+        throw std::runtime_error("cannot emit a C++ function of more than 64 variables");
+    string name = funcname;
+    std::replace(name.begin(), name.end(), '-', '_');
+    cout << "#include <cstdint>" << endl << endl << "// ";
+    print_func_expr(func, first_char, funcname);
+    cout << "inline bool " << name << "(std::uint64_t x)" << endl
+         << "{" << endl
+         << "    return ";
+    if( func.size() == 0 )
+        cout << "false";
+    boost::io::ios_flags_saver ifs(cout);
+    cout << std::hex;
+    for( auto it = func.begin(); it != func.end(); ++it ) {
+        std::uint64_t mask = 0, value = 0;
+        for( int i = 0; i < it->size(); ++i ) {
+            std::uint64_t bit = std::uint64_t(1) << (it->size() - 1 - i);
+            if( (*it)[i] != logical_expr::dont_care ) {
+                mask |= bit;
+                if( *(*it)[i] ) value |= bit;
+            }
+        }
+        if( it != func.begin() )
+            cout << endl << "         | ";
+        cout << "((x & 0x" << mask << "ull) == 0x" << value << "ull)";
+    }
+    cout << ";" << endl << "}" << endl;
+}
+
+void print_decomposition(const quine_mccluskey::decomposer &dec,
+        char first_char = 'A', const string &funcname = "f")
+{
+    cout << endl << "Decomposition:" << endl;
+    cout << "Vacuous variables:";
+    for( int var : dec.get_vacuous_vars() )
+        cout << ' ' << static_cast<char>(first_char + var);
+    cout << endl << "Symmetric variables:";
+    for( const auto &group : dec.get_symmetric_groups() ) {
+        cout << " {";
+        for( auto it = group.begin(); it != group.end(); ++it )
+            cout << (it == group.begin() ? "" : ", ") << static_cast<char>(first_char + *it);
+        cout << '}';
+    }
+    cout << endl;
+    for( int i = 0; i < dec.get_subproblems().size(); ++i )
+        print_func_expr(dec.expand(i, dec.get_subproblems()[i].function),
+            first_char, funcname + std::to_string(i + 1));
+}
+
 int main(int argc, char **argv)
 {
     int exit_code = EXIT_SUCCESS;
     try {
         bool print_process = true;
         char first_char = 'A';
+        bool truth_table = false;
+        bool alloc_count = false;
+        bool decompose = false;
+        bool emit_cpp = false;
+        auto method = quine_mccluskey::simplifier::automatic;
+        unsigned threads = 0;
+        string external_dir;
         constexpr char inverter = '~';
 
         //
@@ -71,6 +139,13 @@ int main(int argc, char **argv)
         opt.add_options()
             ("quiet,q", "never print the information of the process of simplifying")
             ("first-char,c", value<char>(), "specify a character of the first variable used for input expression")
+            ("truth-table,t", "input is a truth table (0x..., 0b...) or a minterm list m(...) with optional d(...)")
+            ("alloc-count", "print the number of allocations made by terms and tables to stderr")
+            ("external-dir", value<string>(), "store compression tables as files in the directory instead of memory (tabular method)")
+            ("decompose,d", "split the function into independent subproblems before simplifying")
+            ("emit-cpp", "print the first result as a branchless C++ function")
+            ("method,m", value<string>(), "method to find prime implicants: tabular, consensus or auto (default)")
+            ("jobs,j", value<unsigned>(), "number of threads used to search minimum covers (default: all cores)")
             ("help,h", "display this help and exit");
         variables_map argmap;
         store(parse_command_line(argc, argv, opt), argmap);
@@ -83,6 +158,29 @@ int main(int argc, char **argv)
             print_process = false;
         if( argmap.count("first-char") )
             first_char = argmap["first-char"].as<char>();
+        if( argmap.count("truth-table") )
+            truth_table = true;
+        if( argmap.count("alloc-count") )
+            alloc_count = true;
+        if( argmap.count("method") ) {
+            const string &name = argmap["method"].as<string>();
+            if( name == "tabular" )
+                method = quine_mccluskey::simplifier::tabular;
+            else if( name == "consensus" )
+                method = quine_mccluskey::simplifier::consensus;
+            else if( name != "auto" )
+                throw std::runtime_error("unknown method: " + name);
+        }
+        if( argmap.count("emit-cpp") )
+            emit_cpp = true;
+        if( argmap.count("decompose") )
+            decompose = true;
+        if( argmap.count("jobs") )
+            threads = argmap["jobs"].as<unsigned>();
+        if( argmap.count("external-dir") )
+            external_dir = argmap["external-dir"].as<string>();
+        if( !external_dir.empty() && method == quine_mccluskey::simplifier::consensus )
+            throw std::runtime_error("--external-dir cannot be used with --method consensus");
 
         // Input a target logical function to be simplfied from stdin
         if( print_process )
@@ -93,35 +191,76 @@ int main(int argc, char **argv)
         string line;
         getline(cin, line);
 
-        // Parse input logical expression and return tokenized
-        logical_expr::function_parser<inverter, true> parser(line, first_char);
-        auto token = parser.parse();
-        // Create a logical function with logical_term<term_mark>
+        // Create a simplifier using Quine-McCluskey algorithm
         typedef quine_mccluskey::simplifier::property_type PropertyType;
         typedef quine_mccluskey::simplifier::term_type TermType;
+        quine_mccluskey::simplifier qm;
+        qm.set_num_threads(threads);
+        qm.set_external_dir(external_dir);
+        qm.set_prime_method(method);
         logical_expr::logical_function<TermType> function;
-        for( string term : token.second )
-            function += logical_expr::parse_logical_term<PropertyType, inverter>(term, token.first.size(), first_char);
+        string funcname;
+        if( truth_table ) {
+            if( decompose )
+                throw std::runtime_error("--decompose cannot be used with --truth-table");
+            // Parse input truth table and load its minterms directly
+            logical_expr::function_parser<inverter, true, logical_expr::truth_table> parser(line, first_char);
+            auto list = parser.parse_minterms();
+            funcname = parser.function_name();
+            qm.load_minterms(list.vars.size(), list.minterms, list.dont_cares);
+        }
+        else {
+            // Parse input logical expression and return tokenized
+            logical_expr::function_parser<inverter, true> parser(line, first_char);
+            auto token = parser.parse();
+            funcname = parser.function_name();
+            // Create a logical function with logical_term<term_mark>
+            for( const string &term : token.second )
+                function += logical_expr::parse_logical_term<PropertyType, inverter>(term, token.first.size(), first_char);
+        }
 
-        // Create a simplifier using Quine-McCluskey algorithm
-        quine_mccluskey::simplifier qm(function);
-        if( print_process ) {
-            cout << endl << "Sum of products form:" << endl;
-            print_truth_table(qm.get_std_spf(), first_char);    // Print the function in sum of products form
-            cout << endl << "Compressing ..." << endl;
-            qm.compress_table(true);                            // Compress the compression table
-            cout << endl << "Prime implicants: " << endl;
-            for( const auto &term : qm.get_prime_implicants() ) {      // Print the prime implicants
-                print_term_expr(term, first_char);
-                cout << "  ";
+        vector<logical_expr::logical_function<TermType>> results;
+        if( decompose ) {
+            // Split the function into subproblems and simplify them in parallel
+            quine_mccluskey::decomposer dec(function);
+            if( print_process ) {
+                print_decomposition(dec, first_char, funcname);
+                cout << endl << "Result of simplifying:" << endl;
             }
-            cout << endl << endl << "Result of simplifying:" << endl;
+            results = dec.simplify(threads, external_dir, method);
+        }
+        else {
+            if( !truth_table ) {
+                qm.set_function(function);
+                qm.make_std_spf();
+            }
+            if( print_process ) {
+                cout << endl << "Sum of products form:" << endl;
+                print_truth_table(qm.get_std_spf(), first_char);    // Print the function in sum of products form
+                if( qm.get_dont_cares().size() )
+                    print_func_expr(qm.get_dont_cares(), first_char, "don't care");
+                cout << endl << "Compressing ..." << endl;
+                qm.compress_table(true);                            // Compress the compression table
+                cout << endl << "Prime implicants: " << endl;
+                for( const auto &term : qm.get_prime_implicants() ) {      // Print the prime implicants
+                    print_term_expr(term, first_char);
+                    cout << "  ";
+                }
+                cout << endl << endl << "Result of simplifying:" << endl;
+            }
+            else
+                qm.compress_table(false);
+            const auto &covers = qm.simplify();
+            results.assign(covers.begin(), covers.end());
         }
-        else
-            qm.compress_table(false);
 
-        for( const auto &func : qm.simplify() )        // Simplify and print its results
-            print_func_expr(func, first_char, parser.function_name() + "\'");
+        if( emit_cpp && !results.empty() )
+            print_cpp_function(results.front(), first_char, funcname);
+        else
+            for( const auto &func : results )   // Print the results of simplifying
+                print_func_expr(func, first_char, funcname + "\'");
+        if( alloc_count )
+            cerr << "[*] Allocations: " << logical_expr::allocation_count() << endl;
     }
     catch( std::exception &e ) {
         cerr << endl << "[-] Exception: " << e.what() << endl;
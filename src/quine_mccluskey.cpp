@@ -3,10 +3,16 @@
 #include <set>
 #include <algorithm>
 #include <stdexcept>
-#include <numeric>
 #include <cmath>
+#include <memory>
+#include <cstdint>
+#include <atomic>
+#include <unistd.h>
+#include <boost/format.hpp>
 #include "logical_expr.hpp"
 #include "quine_mccluskey.hpp"
+#include "cover_solver.hpp"
+#include "external_table.hpp"
 
 using namespace std;
 using namespace logical_expr;
@@ -20,57 +26,118 @@ typedef simplifier::set_type set_type;
 typedef simplifier::table_type table_type;
 
 // Make standard sum of products form
+// Minterms of each term are enumerated instead of evaluating all the arguments
 const logical_function<term_type>& simplifier::make_std_spf() {
     stdspf_.clear();
-    arg_generator<> generator(0, std::pow(2, func_.term_size()), func_.term_size());
-    for( auto arg : generator )
-        if( func_(arg) )
-            stdspf_ += logical_term<term_mark>(arg);
+    counted_vector<unsigned long> minterms;
+    for( const auto &term : func_ )
+        term.for_each_minterm([&](unsigned long index){ minterms.push_back(index); });
+    std::sort(minterms.begin(), minterms.end());
+    minterms.erase(std::unique(minterms.begin(), minterms.end()), minterms.end());
+    stdspf_.reserve(minterms.size());
+    for( auto index : minterms )
+        stdspf_ += term_type::from_index(func_.term_size(), index);
+    width_ = func_.term_size();
     return stdspf_;
 }
 
 const table_type& simplifier::make_min_table() {
-    table_[0].resize(func_.term_size() + 1, set_type());
-    for( auto term : stdspf_ )
+    table_[0].resize(width_ + 1, set_type());
+    // Count the terms of each group first to allocate each group only once
+    counted_vector<int> group_size(table_[0].size(), 0);
+    for( const auto &term : stdspf_ )
+        ++group_size[term.num_of_value(true)];
+    for( const auto &term : dont_cares_ )
+        ++group_size[term.num_of_value(true)];
+    for( int i = 0; i < group_size.size(); ++i )
+        table_[0][i].reserve(table_[0][i].size() + group_size[i]);
+    for( const auto &term : stdspf_ )
+        table_[0][term.num_of_value(true)].push_back(term);
+    for( const auto &term : dont_cares_ )
         table_[0][term.num_of_value(true)].push_back(term);
     return table_[0];
 }
 
+const table_type& simplifier::load_minterms(size_t width,
+        const vector<unsigned long> &minterms, const vector<unsigned long> &dont_cares)
+{
+    if( minterms.empty() )
+        throw std::runtime_error("simplifier: function has no minterm");
+    stdspf_.clear();
+    dont_cares_.clear();
+    stdspf_.reserve(minterms.size());
+    dont_cares_.reserve(dont_cares.size());
+    for( auto index : minterms )
+        stdspf_ += term_type::from_index(width, index);
+    for( auto index : dont_cares )
+        dont_cares_ += term_type::from_index(width, index);
+    // The minterms are the input terms, which are not copied to func_
+    func_.clear();
+    width_ = width;
+    min_level_ = 0;
+    table_.clear();
+    prime_imp.clear();
+    add_table(table_type());
+    return make_min_table();
+}
+
+simplifier::prime_method simplifier::get_prime_method() const {
+    // Only the compression table is stored in files
+    if( method_ == consensus && !external_dir_.empty() )
+        throw std::runtime_error("simplifier: consensus method cannot store terms in an external directory");
+    if( method_ != automatic )
+        return method_;
+    if( !external_dir_.empty() )
+        return tabular;
+    // Iterated consensus pays off when a term covers 4 or more minterms on average
+    const auto &input = input_terms();
+    double minterms = 0;
+    for( const auto &term : input )
+        minterms += std::pow(2.0, term.size() - term.num_of_value(true) - term.num_of_value(false));
+    return (input.size() && 4.0 * input.size() <= minterms) ? consensus : tabular;
+}
+
 void simplifier::compress_table(bool printable) {
+    if( get_prime_method() == consensus ) {
+        make_primes_consensus(printable);
+        return;
+    }
+    if( table_[0].empty() )
+        make_min_table();
+    if( !external_dir_.empty() ) {
+        compress_external(printable);
+        return;
+    }
     for( ;; ) {
         if( printable )
             cout << get_current_level() + 1 << "-level compression:" << endl;
         if( !compress_impl(printable) ) break;
     }
-    for( auto table : table_  )
-        for( auto set : table )
+    for( const auto &table : table_  )
+        for( const auto &set : table )
             for( const logical_term<term_mark> &term : set )
                 if( !property_get(term) )
                     prime_imp.push_back(term);
     make_unique(prime_imp);
 }
 
-const vector<logical_function<term_type>>& simplifier::simplify() {
-    vector<int> next_index(prime_imp.size());
-    std::iota(next_index.begin(), next_index.end(), 0);
-    // bool: wether simplifying finished  int: loop number that simplifying took
-    std::pair<bool, int> end_flags = { false, 0 };
-    for( int i = 1; i <= prime_imp.size(); ++i ) {
-        if( end_flags.first && end_flags.second < i )
-            break;
-        do {
-            logical_function<term_type> func;
-            auto log_func_comp 
-                = [&](const logical_function<term_type> &f){ return f.is_same(func); };
-            for( int j = 0; j < i; ++j )
-                func += prime_imp[next_index[j]];
-            if( func == stdspf_ &&
-                std::find_if(simplified_.begin(), simplified_.end(), log_func_comp)
-                   == simplified_.end() ) {
-                simplified_.push_back(func);
-                end_flags = { true, i };
-            }
-        } while( next_permutation(next_index.begin(), next_index.end()) );
+// Find all the minimum covers of the standard sum of products form
+const counted_vector<logical_function<term_type>>& simplifier::simplify() {
+    simplified_.clear();
+    counted_vector<cover_solver::bitset_type> coverage(prime_imp.size(), cover_solver::bitset_type(stdspf_.size()));
+    for( int i = 0; i < prime_imp.size(); ++i )
+        for( int j = 0; j < stdspf_.size(); ++j )
+            if( prime_imp[i].contains(stdspf_[j]) )
+                coverage[i].set(j);
+    cover_solver solver(coverage, stdspf_.size(), threads_);
+    const auto &covers = solver.solve();
+    simplified_.reserve(covers.size());
+    for( const auto &cover : covers ) {
+        logical_function<term_type> func;
+        func.reserve(cover.size());
+        for( int index : cover )
+            func += prime_imp[index];
+        simplified_.push_back(std::move(func));
     }
     return simplified_;
 }
@@ -79,15 +146,19 @@ void simplifier::add_table(const table_type& table) {
     table_.push_back(table);
 }
 
+void simplifier::add_table(table_type&& table) {
+    table_.push_back(std::move(table));
+}
+
 void simplifier::clear_table() {
     for( int i = 0; i < table_.size(); ++i )
         table_[i].clear();
 }
 
 template<typename T>
-void simplifier::make_unique(vector<T> &vec) {
+void simplifier::make_unique(counted_vector<T> &vec) {
     for( auto it = vec.begin(); it != vec.end(); ++it ) {
-        auto rm_it = remove(it + 1, vec.end(), *it);
+        auto rm_it = remove_if(it + 1, vec.end(), [&](const T &t){ return t.is_same(*it); });
         vec.erase(rm_it, vec.end());
     }
 }
@@ -96,35 +167,137 @@ void simplifier::make_unique(vector<T> &vec) {
 // Return true while trying to find them
 // Return false if it finished
 bool simplifier::compress_impl(bool printable) {
-    table_type next_table;
-    next_table.resize(func_.term_size(), set_type());
+    table_type next_table(width_, set_type());
+    table_type &table = table_[min_level_];
     int count = 0;
-    for( int i = 0; i+1 < table_[min_level_].size(); ++i ) {
-        for( int j = 0; j < table_[min_level_][i].size(); ++j ) {
-            for( int k = 0; k < table_[min_level_][i+1].size(); ++k ) {
-                try {
-                    // Throw an exception if could not minimize
-                    auto term = onebit_minimize(table_[min_level_][i][j], table_[min_level_][i+1][k], false);
-                    if( printable )
-                        cout << "COMPRESS(" << table_[min_level_][i][j] << ", " << table_[min_level_][i+1][k] << ") = " << term << endl;
-                    if( std::find_if(next_table[term.num_of_value(true)].begin(), next_table[term.num_of_value(true)].end(), 
-                                [&](const term_type &t){ return t.is_same(term); }) == next_table[term.num_of_value(true)].end())
-                        next_table[term.num_of_value(true)].push_back(term);
-                    ++count;
-                    // Mark the used term for minimization
-                    property_set(table_[min_level_][i][j], true);
-                    property_set(table_[min_level_][i+1][k], true);
-                } catch( std::exception &e ) {}
+    for( int i = 0; i+1 < table.size(); ++i ) {
+        for( auto &lhs : table[i] ) {
+            for( auto &rhs : table[i+1] ) {
+                if( lhs.diff_size(rhs) != 1 )
+                    continue;
+                auto term = onebit_minimize(lhs, rhs, false);
+                if( printable )
+                    cout << "COMPRESS(" << lhs << ", " << rhs << ") = " << term << endl;
+                set_type &set = next_table[term.num_of_value(true)];
+                if( std::find_if(set.begin(), set.end(),
+                            [&](const term_type &t){ return t.is_same(term); }) == set.end() )
+                    set.push_back(std::move(term));
+                ++count;
+                // Mark the used term for minimization
+                property_set(lhs, true);
+                property_set(rhs, true);
             }
         }
     }
     if( count ) {
         ++min_level_;
-        add_table(next_table);
+        add_table(std::move(next_table));
     }
     return (count ? true : false);
 }
 
 
+// Compress the compression table level by level through files.
+// Only two adjacent levels exist at a time, and no term but prime implicants
+// is held in memory once table_[0] is written to the first file.
+void simplifier::compress_external(bool printable) {
+    typedef external_table::record record;
+    const int width = width_;
+    // Simplifiers running at the same time never share their files
+    static std::atomic<unsigned> table_id(0);
+    const unsigned id = table_id++;
+    auto level_path = [&](int level){
+        return (boost::format("%1%/qm-%2%-%3%-level%4%.tbl") % external_dir_ % ::getpid() % id % level).str();
+    };
+    auto to_record = [&](const term_type &term){
+        uint64_t value = 0, mask = 0;
+        for( int i = 0; i < width; ++i ) {
+            uint64_t bit = uint64_t(1) << (width - 1 - i);
+            if( term[i] != dont_care ) {
+                mask |= bit;
+                if( *term[i] ) value |= bit;
+            }
+        }
+        return external_table::make_record(value, mask);
+    };
+
+    std::unique_ptr<external_table> current(new external_table(level_path(min_level_), width));
+    for( const auto &set : table_[0] )
+        for( const auto &term : set )
+            current->append(to_record(term));
+    current->seal();
+    table_type().swap(table_[0]);
+
+    counted_vector<record> primes;
+    for( ;; ) {
+        if( printable )
+            cout << get_current_level() + 1 << "-level compression:" << endl;
+        std::unique_ptr<external_table> next(new external_table(level_path(min_level_ + 1), width));
+        size_t count = current->combine(*next, printable);
+        current->collect_unused(primes);
+        current->remove();
+        if( !count ) {
+            next->remove();
+            break;
+        }
+        ++min_level_;
+        current = std::move(next);
+    }
+
+    for( const auto &rec : primes ) {
+        term_type term(width);
+        for( int i = 0; i < width; ++i ) {
+            uint64_t bit = uint64_t(1) << (width - 1 - i);
+            if( rec.mask & bit )
+                term[i] = static_cast<bool>(rec.value & bit);
+        }
+        prime_imp.push_back(std::move(term));
+    }
+}
+
+
+// Iterated consensus with single-cube containment.
+// The consensus of every pair of terms is added unless another term contains it,
+// and the terms it contains are removed. Finally the terms are all the prime implicants.
+void simplifier::make_primes_consensus(bool printable) {
+    set_type terms;
+    const auto &input = input_terms();
+    terms.reserve(input.size() + dont_cares_.size());
+    counted_vector<bool> removed;
+    auto add_term = [&](const term_type &term){
+        for( int i = 0; i < terms.size(); ++i )
+            if( !removed[i] && terms[i].contains(term) )
+                return false;
+        for( int i = 0; i < terms.size(); ++i )
+            if( !removed[i] && term.contains(terms[i]) )
+                removed[i] = true;
+        terms.push_back(term);
+        removed.push_back(false);
+        return true;
+    };
+    for( const auto &term : input )
+        add_term(term);
+    for( const auto &term : dont_cares_ )
+        add_term(term);
+
+    // Each term is paired with all the terms before it, including the terms added later
+    for( int j = 1; j < terms.size(); ++j ) {
+        for( int i = 0; i < j && !removed[j]; ++i ) {
+            if( removed[i] )
+                continue;
+            auto term = logical_expr::consensus(terms[i], terms[j]);
+            if( !term )
+                continue;
+            if( add_term(*term) && printable )
+                cout << "CONSENSUS(" << terms[i] << ", " << terms[j] << ") = " << *term << endl;
+        }
+    }
+
+    for( int i = 0; i < terms.size(); ++i )
+        if( !removed[i] )
+            prime_imp.push_back(std::move(terms[i]));
+}
+
+
 }   // namespace quine_mccluskey
 
@@ -26,49 +26,87 @@ using namespace logical_expr;
 //  [*] In the case which simplifier is default-constructed
 //      1. set_function()       // set a target function
 //      2. make_std_spf()       // make a standard sum of products form
-//      3. make_min_table()     // create a compression table
-//      4. same as the case above
+//      3. same as the case above
+//  [*] compress_table() creates the compression table by make_min_table()
+//      only if the tabular method is used and the table is not created yet
+//  [*] In the case of a truth table or a minterm list
+//      1. load_minterms()      // load minterms and don't cares to the compression table
+//      2. same as the first case
+//  [*] compress_table() finds prime implicants by the method set by set_prime_method()
+//      tabular:    compress the compression table level by level
+//      consensus:  iterated consensus of the input terms, whose cost follows
+//                  the number of terms rather than the number of minterms
+//      automatic:  consensus if the input terms are large on average,
+//                  and always tabular if set_external_dir() is used
+//      consensus with set_external_dir() is an error
 //
 class simplifier {
 public:
 
     typedef term_mark property_type;
     typedef logical_term<property_type> term_type;
-    typedef vector<term_type> set_type;
-    typedef vector<set_type> table_type;
-
-    simplifier() : min_level_(0) 
-        { add_table(table_type()); make_min_table(); }
-    explicit simplifier(const logical_function<term_type> &function) : min_level_(0), func_(function)
-        { add_table(table_type()); make_std_spf(); make_min_table(); }
+    typedef counted_vector<term_type> set_type;
+    typedef counted_vector<set_type> table_type;
+    enum prime_method { tabular, consensus, automatic };
+
+    simplifier() : min_level_(0), width_(0), threads_(0), method_(automatic)
+        { add_table(table_type()); }
+    explicit simplifier(const logical_function<term_type> &function)
+        : min_level_(0), width_(0), threads_(0), method_(automatic), func_(function)
+        { add_table(table_type()); make_std_spf(); }
     ~simplifier() {}
 
     void set_function(const logical_function<term_type> &func) { func_ = func; }
+    // Number of threads used by simplify() (0: hardware concurrency)
+    void set_num_threads(unsigned threads) { threads_ = threads; }
+    // Store compression levels in files under directory instead of memory
+    // (empty: compress in memory)
+    void set_external_dir(const string &directory) { external_dir_ = directory; }
+    void set_prime_method(prime_method method) { method_ = method; }
+    // Return tabular or consensus which compress_table() uses
+    prime_method get_prime_method() const;
     int get_current_level() const { return min_level_; }
     const logical_function<term_type>& get_std_spf() const { return stdspf_; }
+    const logical_function<term_type>& get_dont_cares() const { return dont_cares_; }
     const set_type& get_prime_implicants() const { return prime_imp; }
 
     // Make standard sum of products form
     const logical_function<term_type>& make_std_spf();
     const table_type& make_min_table();   
+    // Load minterms directly into the compression table
+    // The target function is not evaluated
+    const table_type& load_minterms(size_t width, const vector<unsigned long> &minterms,
+            const vector<unsigned long> &dont_cares = vector<unsigned long>());
     void compress_table(bool printable = false);
-    const vector<logical_function<term_type>>& simplify();    
+    const counted_vector<logical_function<term_type>>& simplify();    
 
 private:
     void add_table(const table_type& table);
+    void add_table(table_type&& table);
     void clear_table();
     template<typename T>
-    static void make_unique(vector<T> &vec);
+    static void make_unique(counted_vector<T> &vec);
 
     // compress compression table
     // return true while trying to compress
     // return false if compression finished
     bool compress_impl(bool printable = false);
+    // compress compression table stored in files
+    void compress_external(bool printable = false);
+    // find prime implicants by iterated consensus of the input terms
+    void make_primes_consensus(bool printable = false);
+    // the target function, or the minterms if they are loaded by load_minterms()
+    const logical_function<term_type>& input_terms() const
+        { return func_.size() ? func_ : stdspf_; }
 
     int min_level_;
-    logical_function<term_type> func_, stdspf_;
-    vector<logical_function<term_type>> simplified_;
-    vector<table_type> table_;
+    size_t width_;
+    unsigned threads_;
+    string external_dir_;
+    prime_method method_;
+    logical_function<term_type> func_, stdspf_, dont_cares_;
+    counted_vector<logical_function<term_type>> simplified_;
+    counted_vector<table_type> table_;
     set_type prime_imp;
 };
 
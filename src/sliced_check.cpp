@@ -0,0 +1,121 @@
+
+//
+// Run-time checks of the bit-sliced evaluation in logical_expr.hpp
+// slice_arguments() and calculate_sliced() of terms and functions are compared
+// with calculate() for 1 to 64 arguments; make check builds and runs this program
+//
+#include <iostream>
+#include <stdexcept>
+#include <cstdint>
+#include <boost/format.hpp>
+#include "logical_expr.hpp"
+
+using namespace std;
+using namespace logical_expr;
+
+namespace {
+
+
+typedef logical_term<term_mark> term_type;
+typedef logical_function<term_type> function_type;
+// Two 64-bit words in a vector type of the compiler (SIMD)
+typedef std::uint64_t lanes_type __attribute__((vector_size(16)));
+
+// Pseudo-random numbers which are the same on every run
+std::uint64_t next_random(std::uint64_t &state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+term_type random_term(int width, std::uint64_t &state) {
+    term_type term(width);
+    for( int i = 0; i < width; ++i ) {
+        int value = next_random(state) % 3;
+        if( value < 2 )
+            term[i] = static_cast<bool>(value);
+    }
+    return term;
+}
+
+// Mask of the lower count bits
+std::uint64_t valid_bits(std::size_t count) {
+    return count == 64 ? ~std::uint64_t() : (std::uint64_t(1) << count) - 1;
+}
+
+// Compare the sliced results of the terms and the function with calculate()
+// The bits past count have to be the value for the minterm 0
+template<typename Function>
+void check(const Function &func, const std::uint64_t *args, std::size_t count, int width) {
+    counted_vector<std::uint64_t> vars(width);
+    slice_arguments(args, count, width, vars.data());
+    std::uint64_t expected = 0;
+    for( std::size_t k = 0; k < count; ++k )
+        if( func.calculate(boost::dynamic_bitset<>(width, args[k])) )
+            expected |= std::uint64_t(1) << k;
+    if( func.calculate(boost::dynamic_bitset<>(width, 0)) )
+        expected |= ~valid_bits(count);
+    if( func.calculate_sliced(vars.data()) != expected )
+        throw std::runtime_error((boost::format("sliced_check: %1% differs for %2% arguments") % func % count).str());
+}
+
+// Each lane holds the arguments of another call of slice_arguments()
+void check_lanes(const function_type &func, const std::uint64_t *args, std::size_t count, int width) {
+    const int lanes = sizeof(lanes_type) / sizeof(std::uint64_t);
+    lanes_type vars[64];
+    counted_vector<std::uint64_t> lane_vars(width);
+    for( int lane = 0; lane < lanes; ++lane ) {
+        slice_arguments(args + lane * count, count, width, lane_vars.data());
+        for( int i = 0; i < width; ++i )
+            vars[i][lane] = lane_vars[i];
+    }
+    lanes_type result = func.calculate_sliced(vars);
+    for( int lane = 0; lane < lanes; ++lane ) {
+        slice_arguments(args + lane * count, count, width, lane_vars.data());
+        if( (result[lane] & valid_bits(count)) != (func.calculate_sliced(lane_vars.data()) & valid_bits(count)) )
+            throw std::runtime_error((boost::format("sliced_check: lane %1% differs for %2% arguments") % lane % count).str());
+    }
+}
+
+
+}   // namespace
+
+
+int main() {
+    try {
+        std::uint64_t state = 88172645463325252ull;
+        std::size_t checked = 0;
+        for( int width : { 1, 2, 5, 8, 13, 20, 33, 64 } ) {
+            function_type func;
+            for( int t = 0; t < 6; ++t )
+                func += random_term(width, state);
+            // Half of the arguments are made to satisfy a term
+            std::uint64_t args[4 * 64];
+            for( auto &arg : args ) {
+                arg = next_random(state) & valid_bits(width);
+                if( next_random(state) % 2 == 0 )
+                    continue;
+                const term_type &term = func[next_random(state) % func.size()];
+                for( int i = 0; i < width; ++i ) {
+                    std::uint64_t bit = std::uint64_t(1) << (width - 1 - i);
+                    if( term[i] != dont_care )
+                        arg = *term[i] ? (arg | bit) : (arg & ~bit);
+                }
+            }
+            for( std::size_t count = 1; count <= 64; ++count ) {
+                for( const auto &term : func )
+                    check(term, args, count, width);
+                check(func, args, count, width);
+                check_lanes(func, args, count, width);
+                checked += count;
+            }
+        }
+        cout << "sliced_check: " << checked << " arguments of each function checked" << endl;
+    }
+    catch( std::exception &e ) {
+        cerr << "[-] Exception: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}